@@ -1,11 +1,14 @@
 #include <getopt.h>
 
 #include <default_params.hpp>
+#include <distance_oracle.hpp>
 #include <flow_network.hpp>
 #include <iostream>
 #include <naive_tswap.hpp>
 #include <problem.hpp>
 #include <random>
+#include <sstream>
+#include <thread>
 #include <tswap.hpp>
 #include <util.hpp>
 #include <vector>
@@ -13,6 +16,9 @@
 void printHelp();
 std::unique_ptr<Solver> getSolver(const std::string solver_name, Problem *P,
                                   bool verbose, int argc, char *argv[]);
+void solveSweep(Problem *P, const std::string &sweep_list,
+                const std::string solver_name, const std::string &output_file,
+                bool verbose, int argc, char *argv[]);
 
 int main(int argc, char *argv[])
 {
@@ -30,15 +36,19 @@ int main(int argc, char *argv[])
       {"verbose", no_argument, 0, 'v'},
       {"help", no_argument, 0, 'h'},
       {"make-scen", no_argument, 0, 'P'},
+      {"make-oracle", required_argument, 0, 'M'},
+      {"sweep", required_argument, 0, 'S'},
       {0, 0, 0, 0},
   };
   bool make_scen = false;
+  std::string oracle_file = "";
+  std::string sweep_list = "";
 
   // command line args
   int opt, longindex;
   opterr = 0;  // ignore getopt error
-  while ((opt = getopt_long(argc, argv, "i:o:s:vhP", longopts, &longindex)) !=
-         -1) {
+  while ((opt = getopt_long(argc, argv, "i:o:s:vhPM:S:", longopts,
+                            &longindex)) != -1) {
     switch (opt) {
       case 'i':
         instance_file = std::string(optarg);
@@ -58,6 +68,12 @@ int main(int argc, char *argv[])
       case 'P':
         make_scen = true;
         break;
+      case 'M':
+        oracle_file = std::string(optarg);
+        break;
+      case 'S':
+        sweep_list = std::string(optarg);
+        break;
       default:
         break;
     }
@@ -81,6 +97,21 @@ int main(int argc, char *argv[])
     return 0;
   }
 
+  // precompute distances of the map
+  if (!oracle_file.empty()) {
+    DistanceOracle::build(P.getG(), oracle_file,
+                          std::thread::hardware_concurrency());
+    if (verbose) std::cout << "save oracle as " << oracle_file << std::endl;
+    return 0;
+  }
+
+  // solve prefixes of the instance on the same map
+  if (!sweep_list.empty()) {
+    solveSweep(&P, sweep_list, solver_name, output_file, verbose, argc,
+               argv_copy);
+    return 0;
+  }
+
   // solve
   std::unique_ptr<Solver> solver =
       getSolver(solver_name, &P, verbose, argc, argv_copy);
@@ -118,6 +149,55 @@ std::unique_ptr<Solver> getSolver(const std::string solver_name, Problem *P,
   return solver;
 }
 
+void solveSweep(Problem *P, const std::string &sweep_list,
+                const std::string solver_name, const std::string &output_file,
+                bool verbose, int argc, char *argv[])
+{
+  // e.g., 110,500,1000
+  std::vector<int> agents_list;
+  std::stringstream ss(sweep_list);
+  std::string token;
+  while (std::getline(ss, token, ',')) {
+    const int num = std::atoi(token.c_str());
+    if (num <= 0 || num > P->getNum()) {
+      halt("invalid number of agents for sweep, " + token);
+    }
+    agents_list.push_back(num);
+  }
+
+  // result.txt -> result_110agents.txt
+  const auto dot = output_file.find_last_of('.');
+  const auto slash = output_file.find_last_of('/');
+  const bool has_ext =
+      dot != std::string::npos && (slash == std::string::npos || dot > slash);
+  const std::string stem = has_ext ? output_file.substr(0, dot) : output_file;
+  const std::string ext = has_ext ? output_file.substr(dot) : "";
+
+  // distance fields of goals are reused by later problems
+  auto field_cache = LibGA::FieldCache::getShared();
+  const auto config_s = P->getConfigStart();
+  const auto config_g = P->getConfigGoal();
+  for (auto num : agents_list) {
+    Problem Q = Problem(
+        P, Config(config_s.begin(), config_s.begin() + num),
+        Config(config_g.begin(), config_g.begin() + num),
+        P->getMaxCompTime(), P->getMaxTimestep());
+    std::unique_ptr<Solver> solver =
+        getSolver(solver_name, &Q, verbose, argc, argv);
+    auto tswap = dynamic_cast<TSWAP *>(solver.get());
+    if (tswap != nullptr) tswap->setFieldCache(field_cache);
+    solver->solve();
+    if (solver->succeed() && !solver->getSolution().validate(&Q)) {
+      halt("invalid results");
+    }
+    solver->printResult();
+
+    const std::string file = stem + "_" + std::to_string(num) + "agents" + ext;
+    solver->makeLog(file);
+    if (verbose) std::cout << "save result as " << file << std::endl;
+  }
+}
+
 void printHelp()
 {
   std::cout << "\nUsage: ./app [OPTIONS] [SOLVER-OPTIONS]\n"
@@ -128,7 +208,13 @@ void printHelp()
             << "  -h --help                     help\n"
             << "  -s --solver [SOLVER_NAME]     solver, choose from the below\n"
             << "  -P --make-scen                make scenario file using "
-               "random starts/goals"
+               "random starts/goals\n"
+            << "  -M --make-oracle [FILE_PATH]  make distance oracle of the "
+               "map, then exit\n"
+            << "  -S --sweep [NUMS]             solve prefixes of the "
+               "instance with each number\n"
+            << "                                of agents, e.g., 110,500,1000,"
+               " sharing distances"
             << "\n\nSolver Options:" << std::endl;
   // each solver
   FlowNetwork::printHelp();
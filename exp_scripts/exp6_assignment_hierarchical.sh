@@ -0,0 +1,26 @@
+#!/bin/sh
+# gaps of hierarchical assignment against flat bottleneck-linear,
+# compare estimated_makespan and estimated_soc in logs
+flocking_blocks=0
+scen_start=1
+scen_end=10
+force=0
+
+set -e
+
+for map in lak303d.map den520d.map orz900d.map
+do
+    agents_list="1000 2000 5000 10000"
+    if [ $map = "lak303d.map" ]
+    then
+        agents_list="1000 2000 5000"
+    fi
+
+    # bottleneck-linear
+    solver="TSWAP -m 0"
+    sh `dirname $0`/run.sh $map "$agents_list" "$solver" $scen_start $scen_end $flocking_blocks $force
+
+    # hierarchical
+    solver="TSWAP -m 9"
+    sh `dirname $0`/run.sh $map "$agents_list" "$solver" $scen_start $scen_end $flocking_blocks $force
+done
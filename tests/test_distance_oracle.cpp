@@ -0,0 +1,42 @@
+#include <distance_oracle.hpp>
+#include <goal_allocator.hpp>
+
+#include "gtest/gtest.h"
+
+TEST(DistanceOracle, all_pairs)
+{
+  Problem P = Problem("../tests/instances/05.txt");
+  Graph* G = P.getG();
+  const std::string file = "./test_distance_oracle.bin";
+  DistanceOracle::build(G, file, 2);
+  DistanceOracle oracle = DistanceOracle(G, file);
+
+  for (auto s : G->getV()) {
+    for (auto g : G->getV()) ASSERT_EQ(oracle.get(s, g), G->pathDist(s, g));
+  }
+  std::remove(file.c_str());
+}
+
+TEST(DistanceOracle, goal_allocator)
+{
+  Problem P = Problem("../tests/instances/07.txt");
+  const std::string file = "./test_distance_oracle.bin";
+  DistanceOracle::build(P.getG(), file);
+
+  GoalAllocator allocator = GoalAllocator(&P, GoalAllocator::GREEDY_SWAP);
+  allocator.assign();
+  GoalAllocator allocator_oracle =
+      GoalAllocator(&P, GoalAllocator::GREEDY_SWAP);
+  allocator_oracle.setOracle(std::make_shared<DistanceOracle>(P.getG(), file));
+  allocator_oracle.assign();
+
+  // ties are broken by start indexes instead of BFS order
+  ASSERT_TRUE(permutatedConfig(allocator_oracle.getAssignedGoals(),
+                               P.getConfigGoal()));
+  ASSERT_EQ(allocator.getMakespan(), allocator_oracle.getMakespan());
+
+  // no BFS at startup
+  ASSERT_TRUE(allocator.getLazyEvalExpanded() > 0);
+  ASSERT_EQ(allocator_oracle.getLazyEvalExpanded(), 0);
+  std::remove(file.c_str());
+}
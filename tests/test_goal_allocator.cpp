@@ -50,3 +50,391 @@ TEST(GoalAllocator, large_field_without_optimization)
   ASSERT_EQ(allocator.getMakespan(), 40);
   ASSERT_TRUE(allocator.getCost() >= 7288);
 }
+
+TEST(GoalAllocator, multi_threads)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  GoalAllocator allocator_serial = GoalAllocator(&P, GoalAllocator::LINEAR);
+  allocator_serial.assign();
+  GoalAllocator allocator_parallel = GoalAllocator(&P, GoalAllocator::LINEAR);
+  allocator_parallel.setThreads(4);
+  allocator_parallel.assign();
+
+  ASSERT_EQ(allocator_serial.getAssignedGoals(),
+            allocator_parallel.getAssignedGoals());
+  ASSERT_EQ(allocator_serial.getCost(), allocator_parallel.getCost());
+  for (int i = 0; i < P.getNum(); ++i) {
+    ASSERT_EQ(allocator_serial.getLazyEval(i, i),
+              allocator_parallel.getLazyEval(i, i));
+  }
+}
+
+TEST(GoalAllocator, landmarks)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  GoalAllocator allocator = GoalAllocator(&P);
+  allocator.setLandmarks(std::make_shared<LibGA::Landmarks>(P.getG(), 8));
+  allocator.assign();
+  Nodes assigned_goals = allocator.getAssignedGoals();
+
+  ASSERT_TRUE(permutatedConfig(assigned_goals, P.getConfigGoal()));
+  ASSERT_EQ(allocator.getMakespan(), 40);
+  ASSERT_EQ(allocator.getCost(), 7288);
+
+  // refinement skips BFS with tighter bounds, with the same result
+  GoalAllocator allocator_swap = GoalAllocator(&P, GoalAllocator::GREEDY_SWAP);
+  allocator_swap.assign();
+  GoalAllocator allocator_swap_lm =
+      GoalAllocator(&P, GoalAllocator::GREEDY_SWAP);
+  allocator_swap_lm.setLandmarks(
+      std::make_shared<LibGA::Landmarks>(P.getG(), 8));
+  allocator_swap_lm.assign();
+  ASSERT_EQ(allocator_swap_lm.getAssignedGoals(),
+            allocator_swap.getAssignedGoals());
+  ASSERT_TRUE(allocator_swap_lm.getLazyEvalAvoided() > 0);
+  ASSERT_EQ(allocator_swap.getLazyEvalAvoided(), 0);
+  ASSERT_TRUE(allocator_swap_lm.getLazyEvalExpanded() <
+              allocator_swap.getLazyEvalExpanded());
+}
+
+TEST(GoalAllocator, auction)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  GoalAllocator allocator =
+      GoalAllocator(&P, GoalAllocator::BOTTLENECK_LINEAR_AUCTION);
+  allocator.setThreads(4);
+  allocator.assign();
+  Nodes assigned_goals = allocator.getAssignedGoals();
+
+  ASSERT_TRUE(permutatedConfig(assigned_goals, P.getConfigGoal()));
+  ASSERT_EQ(allocator.getMakespan(), 40);
+  ASSERT_EQ(allocator.getCost(), 7288);
+
+  GoalAllocator allocator_gap =
+      GoalAllocator(&P, GoalAllocator::BOTTLENECK_LINEAR_AUCTION);
+  allocator_gap.setAuctionGap(0.05);
+  allocator_gap.assign();
+  ASSERT_TRUE(permutatedConfig(allocator_gap.getAssignedGoals(),
+                               P.getConfigGoal()));
+  ASSERT_TRUE(allocator_gap.getCost() <= 7288 * 1.05);
+}
+
+TEST(GoalAllocator, per_pair_matching)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  GoalAllocator allocator = GoalAllocator(&P, GoalAllocator::BOTTLENECK);
+  allocator.setLevelBatch(false);
+  allocator.assign();
+  Nodes assigned_goals = allocator.getAssignedGoals();
+
+  ASSERT_TRUE(permutatedConfig(assigned_goals, P.getConfigGoal()));
+  ASSERT_EQ(allocator.getMakespan(), 40);
+}
+
+TEST(GoalAllocator, refine_by_index)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+
+  // the same swaps are found for the makespan
+  GoalAllocator allocator_index = GoalAllocator(&P, GoalAllocator::GREEDY_SWAP);
+  allocator_index.assign();
+  GoalAllocator allocator_all = GoalAllocator(&P, GoalAllocator::GREEDY_SWAP);
+  allocator_all.setRefineExhaustive(true);
+  allocator_all.assign();
+  ASSERT_EQ(allocator_index.getAssignedGoals(),
+            allocator_all.getAssignedGoals());
+
+  // sum of costs, no improving swap remains
+  GoalAllocator allocator_soc =
+      GoalAllocator(&P, GoalAllocator::GREEDY_SWAP_COST);
+  allocator_soc.assign();
+  auto goals = allocator_soc.getAssignedGoals();
+  ASSERT_TRUE(permutatedConfig(goals, P.getConfigGoal()));
+  std::vector<int> goal_index(P.getG()->getNodesSize(), -1);
+  for (int j = 0; j < P.getNum(); ++j) goal_index[P.getGoal(j)->id] = j;
+  for (int i = 0; i < P.getNum(); ++i) {
+    const int c_i = allocator_soc.getLazyEval(i, goal_index[goals[i]->id]);
+    for (int j = i + 1; j < P.getNum(); ++j) {
+      const int c_j = allocator_soc.getLazyEval(j, goal_index[goals[j]->id]);
+      const int c_swap =
+          allocator_soc.getLazyEval(i, goal_index[goals[j]->id]) +
+          allocator_soc.getLazyEval(j, goal_index[goals[i]->id]);
+      ASSERT_TRUE(c_swap >= c_i + c_j);
+    }
+  }
+}
+
+// assigned goals are a permutation of the goals, indexes match both ways
+static void checkIncremental(const GoalAllocator& allocator)
+{
+  auto assigned_goals = allocator.getAssignedGoals();
+  auto goals = allocator.getGoals();
+  ASSERT_EQ(assigned_goals.size(), goals.size());
+  ASSERT_TRUE(permutatedConfig(assigned_goals, goals));
+  for (int i = 0; i < (int)goals.size(); ++i) {
+    const int j = allocator.getAgentGoal(i);
+    ASSERT_EQ(allocator.getGoalAgent(j), i);
+    ASSERT_EQ(assigned_goals[i], goals[j]);
+  }
+}
+
+TEST(GoalAllocator, incremental)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  GoalAllocator allocator = GoalAllocator(&P);
+  allocator.assign();
+
+  // nodes used neither as starts nor as goals
+  std::vector<bool> used(P.getG()->getNodesSize(), false);
+  for (auto v : P.getConfigStart()) used[v->id] = true;
+  for (auto v : P.getConfigGoal()) used[v->id] = true;
+  Nodes free_nodes;
+  for (auto v : P.getG()->getV()) {
+    if (!used[v->id]) free_nodes.push_back(v);
+  }
+
+  allocator.replaceGoal(0, free_nodes[0]);
+  allocator.reassign();
+  checkIncremental(allocator);
+  allocator.moveAgent(1, free_nodes[1]);
+  allocator.reassign();
+  checkIncremental(allocator);
+  allocator.addAgent(free_nodes[2], free_nodes[3]);
+  allocator.reassign();
+  checkIncremental(allocator);
+  allocator.removeGoal(2);
+  allocator.reassign();
+  checkIncremental(allocator);
+
+  // the goal of the last agent, which is not the last goal
+  const int last = P.getNum() - 1;
+  ASSERT_NE(allocator.getAgentGoal(last), last);
+  allocator.removeGoal(allocator.getAgentGoal(last));
+  allocator.reassign();
+  checkIncremental(allocator);
+
+  // compared with the assignment from scratch
+  auto starts = allocator.getStarts();
+  auto goals = allocator.getGoals();
+  ASSERT_EQ(goals.size(), P.getConfigGoal().size() - 1);
+  Problem Q = Problem(&P, starts, goals, P.getMaxCompTime(),
+                      P.getMaxTimestep());
+  GoalAllocator allocator_scratch = GoalAllocator(&Q);
+  allocator_scratch.assign();
+  ASSERT_EQ(allocator.getMakespan(), allocator_scratch.getMakespan());
+}
+
+TEST(GoalAllocator, incremental_shared_node)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  for (auto mode : {GoalAllocator::BOTTLENECK_LINEAR, GoalAllocator::LINEAR}) {
+    GoalAllocator allocator = GoalAllocator(&P, mode);
+    allocator.assign();
+
+    // two agents on the same node, goals are changed around them
+    auto v = P.getStart(0);
+    allocator.moveAgent(1, v);
+    allocator.addAgent(v, P.getStart(2));
+    allocator.replaceGoal(0, P.getStart(3));
+    allocator.reassign();
+
+    // each goal is assigned to exactly one agent
+    auto assigned_goals = allocator.getAssignedGoals();
+    auto goals = allocator.getGoals();
+    ASSERT_EQ(assigned_goals.size(), goals.size());
+    ASSERT_TRUE(permutatedConfig(assigned_goals, goals));
+    int cost = 0;
+    auto starts = allocator.getStarts();
+    for (int i = 0; i < (int)starts.size(); ++i) {
+      int j = 0;
+      while (goals[j] != assigned_goals[i]) ++j;
+      cost += allocator.getLazyEval(starts[i], j);
+    }
+    ASSERT_EQ(allocator.getCost(), cost);
+  }
+}
+
+TEST(GoalAllocator, hierarchical)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  GoalAllocator allocator = GoalAllocator(&P, GoalAllocator::HIERARCHICAL);
+  allocator.assign();
+  Nodes assigned_goals = allocator.getAssignedGoals();
+
+  ASSERT_TRUE(permutatedConfig(assigned_goals, P.getConfigGoal()));
+
+  // gap to the flat assignment of mode 0, i.e., makespan 40 and cost 7288
+  ASSERT_EQ(allocator.getMakespan(), 40);
+  ASSERT_TRUE(allocator.getCost() >= 7288);
+  ASSERT_TRUE(allocator.getCost() <= 7288 * 105 / 100);
+}
+
+TEST(GoalAllocator, linear_sparse)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  GoalAllocator allocator = GoalAllocator(&P, GoalAllocator::LINEAR);
+  allocator.assign();
+
+  GoalAllocator allocator_sparse =
+      GoalAllocator(&P, GoalAllocator::LINEAR_SPARSE);
+  allocator_sparse.assign();
+  Nodes assigned_goals = allocator_sparse.getAssignedGoals();
+
+  ASSERT_TRUE(permutatedConfig(assigned_goals, P.getConfigGoal()));
+  ASSERT_EQ(allocator_sparse.getCost(), allocator.getCost());
+}
+
+TEST(GoalAllocator, field_cache)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  GoalAllocator allocator = GoalAllocator(&P, GoalAllocator::BOTTLENECK_LINEAR);
+  allocator.assign();
+
+  // distances of goals are reused by a subproblem
+  auto field_cache = std::make_shared<LibGA::FieldCache>();
+  const int N = P.getNum() / 2;
+  auto config_s = P.getConfigStart();
+  auto config_g = P.getConfigGoal();
+  Problem Q = Problem(&P, Config(config_s.begin(), config_s.begin() + N),
+                      Config(config_g.begin(), config_g.begin() + N),
+                      P.getMaxCompTime(), P.getMaxTimestep());
+  GoalAllocator allocator_sub =
+      GoalAllocator(&Q, GoalAllocator::BOTTLENECK_LINEAR);
+  allocator_sub.assign();
+
+  {
+    GoalAllocator allocator_cached =
+        GoalAllocator(&Q, GoalAllocator::BOTTLENECK_LINEAR);
+    allocator_cached.setFieldCache(field_cache);
+    allocator_cached.assign();
+    ASSERT_EQ(allocator_cached.getCost(), allocator_sub.getCost());
+    ASSERT_EQ(allocator_cached.getMakespan(), allocator_sub.getMakespan());
+  }
+  ASSERT_EQ(field_cache->size(), N);
+  ASSERT_EQ(field_cache->getMisses(), N);
+
+  {
+    GoalAllocator allocator_all =
+        GoalAllocator(&P, GoalAllocator::BOTTLENECK_LINEAR);
+    allocator_all.setFieldCache(field_cache);
+    allocator_all.assign();
+    ASSERT_EQ(allocator_all.getCost(), allocator.getCost());
+    ASSERT_EQ(allocator_all.getMakespan(), allocator.getMakespan());
+    ASSERT_EQ(field_cache->size(), 0);
+    ASSERT_EQ(field_cache->getHits(), N);
+  }
+  ASSERT_EQ(field_cache->size(), P.getNum());
+
+  // least recently checked-in fields are evicted
+  field_cache->setCapacity(field_cache->getMemoryUsage() - 1);
+  ASSERT_EQ(field_cache->getEvictions(), 1);
+  field_cache->setCapacity(0);
+  ASSERT_EQ(field_cache->size(), 0);
+  ASSERT_EQ(field_cache->getEvictions(), P.getNum());
+}
+
+TEST(GoalAllocator, repair_fields)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  GoalAllocator allocator = GoalAllocator(&P, GoalAllocator::BOTTLENECK_LINEAR);
+  allocator.assign();
+
+  // block nodes except for starts and goals
+  auto starts = P.getConfigStart();
+  auto goals = P.getConfigGoal();
+  Nodes V = P.getG()->getV();
+  Nodes blocked;
+  for (int k = 0; k < (int)V.size(); k += 37) {
+    auto v = V[k];
+    if (inArray(v, starts) || inArray(v, goals)) continue;
+    P.blockNode(v);
+    blocked.push_back(v);
+  }
+  ASSERT_TRUE(P.isBlocked(blocked[0]));
+  ASSERT_TRUE(blocked[0]->neighbor.empty());
+  allocator.repairFields(blocked, {});
+
+  auto check = [&]() {
+    GoalAllocator allocator_new = GoalAllocator(&P, GoalAllocator::GREEDY);
+    for (int j = 0; j < P.getNum(); j += 7) {
+      for (int i = 0; i < P.getNum(); ++i) {
+        ASSERT_EQ(allocator.getLazyEval(i, j), allocator_new.getLazyEval(i, j));
+      }
+    }
+  };
+  check();
+
+  // unblock half of them
+  Nodes unblocked;
+  for (int k = 0; k < (int)blocked.size(); k += 2) {
+    P.unblockNode(blocked[k]);
+    unblocked.push_back(blocked[k]);
+  }
+  ASSERT_FALSE(P.isBlocked(unblocked[0]));
+  allocator.repairFields({}, unblocked);
+  check();
+}
+
+TEST(GoalAllocator, resumable_astar)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  GoalAllocator allocator = GoalAllocator(&P, GoalAllocator::GREEDY_SWAP);
+  allocator.assign();
+
+  GoalAllocator allocator_astar =
+      GoalAllocator(&P, GoalAllocator::GREEDY_SWAP);
+  allocator_astar.setResumableAstar(true);
+  allocator_astar.assign();
+  ASSERT_EQ(allocator_astar.getCost(), allocator.getCost());
+
+  GoalAllocator allocator_bfs = GoalAllocator(&P, GoalAllocator::GREEDY);
+  for (int j = 0; j < P.getNum(); j += 7) {
+    for (int i = 0; i < P.getNum(); ++i) {
+      ASSERT_EQ(allocator_astar.getLazyEval(i, j),
+                allocator_bfs.getLazyEval(i, j));
+    }
+  }
+}
+
+TEST(GoalAllocator, next_hop)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  GoalAllocator allocator = GoalAllocator(&P, GoalAllocator::GREEDY);
+  ASSERT_EQ(allocator.getNextHop(P.getStart(0), 0), nullptr);
+  allocator.setNextHop(true);
+
+  // BFS is not forced by queries
+  ASSERT_EQ(allocator.getNextHop(P.getStart(0), 0), nullptr);
+  ASSERT_EQ(allocator.getLazyEvalExpanded(), 0);
+  allocator.getLazyEval(P.getStart(0), 0);
+  ASSERT_EQ(allocator.getNextHop(P.getStart(0), 0), nullptr);
+
+  // BFS is finished by querying an unreachable node
+  auto starts = P.getConfigStart();
+  auto goals = P.getConfigGoal();
+  Node* blocked = nullptr;
+  for (auto v : P.getG()->getV()) {
+    if (inArray(v, starts) || inArray(v, goals)) continue;
+    blocked = v;
+    break;
+  }
+  P.blockNode(blocked);
+  allocator.repairFields({blocked}, {});
+
+  // the first neighbor closer to the goal, nullptr for unreachable nodes
+  const int inf = P.getG()->getNodesSize();
+  for (int j = 0; j < P.getNum(); j += 7) {
+    ASSERT_EQ(allocator.getLazyEval(blocked, j), inf);
+    for (auto v : P.getG()->getV()) {
+      const int d = allocator.getLazyEval(v, j);
+      Node* u = (d == inf && !v->neighbor.empty()) ? nullptr : v;
+      for (auto m : v->neighbor) {
+        if (d != inf && allocator.getLazyEval(m, j) < d) {
+          u = m;
+          break;
+        }
+      }
+      ASSERT_EQ(allocator.getNextHop(v, j), u);
+    }
+  }
+}
@@ -0,0 +1,127 @@
+#include <lib_ga.hpp>
+#include <problem.hpp>
+
+#include "gtest/gtest.h"
+
+TEST(DistanceField, lazy_tiles)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  Graph* G = P.getG();
+  auto grid = reinterpret_cast<Grid*>(G);
+  const int inf = G->getNodesSize();
+  auto field = LibGA::DistanceField(grid, inf, false);
+
+  ASSERT_EQ(field.getMemoryUsage(), 0);
+  ASSERT_EQ(field.get(P.getStart(0)), inf);
+
+  field.set(P.getStart(0), 3);
+  ASSERT_EQ(field.get(P.getStart(0)), 3);
+  const size_t tile_bytes = LibGA::DistanceField::TILE_SIZE * sizeof(uint16_t);
+  ASSERT_EQ(field.getMemoryUsage(), tile_bytes);
+
+  auto wide_field = LibGA::DistanceField(grid, inf, true);
+  wide_field.set(P.getGoal(0), 70000);
+  ASSERT_EQ(wide_field.get(P.getGoal(0)), 70000);
+  ASSERT_EQ(wide_field.get(P.getStart(0)), inf);
+}
+
+TEST(MultiSourceBFS, same_as_bfs)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  Graph* G = P.getG();
+  auto grid = reinterpret_cast<Grid*>(G);
+  const int inf = G->getNodesSize();
+  const int K = std::min(P.getNum(), LibGA::MultiSourceBFS::BATCH_SIZE);
+
+  Nodes goals;
+  std::vector<LibGA::DistanceField> fields;
+  std::vector<std::queue<Node*>> opens(K);
+  for (int i = 0; i < K; ++i) {
+    goals.push_back(P.getGoal(i));
+    fields.emplace_back(grid, inf, false);
+  }
+  std::vector<LibGA::DistanceField*> field_ptrs;
+  std::vector<std::queue<Node*>*> open_ptrs;
+  for (int i = 0; i < K; ++i) {
+    field_ptrs.push_back(&fields[i]);
+    open_ptrs.push_back(&opens[i]);
+  }
+  LibGA::MultiSourceBFS::run(G, goals, P.getConfigStart(), field_ptrs,
+                             open_ptrs);
+
+  for (int i = 0; i < K; ++i) {
+    // reference
+    std::vector<int> dist(G->getNodesSize(), inf);
+    std::queue<Node*> OPEN;
+    dist[goals[i]->id] = 0;
+    OPEN.push(goals[i]);
+    while (!OPEN.empty()) {
+      auto n = OPEN.front();
+      OPEN.pop();
+      for (auto m : n->neighbor) {
+        if (dist[m->id] != inf) continue;
+        dist[m->id] = dist[n->id] + 1;
+        OPEN.push(m);
+      }
+    }
+
+    for (auto s : P.getConfigStart()) ASSERT_EQ(fields[i].get(s), dist[s->id]);
+
+    // resume as lazy evaluation
+    while (!opens[i].empty()) {
+      auto n = opens[i].front();
+      opens[i].pop();
+      for (auto m : n->neighbor) {
+        if (fields[i].get(n) + 1 >= fields[i].get(m)) continue;
+        fields[i].set(m, fields[i].get(n) + 1);
+        opens[i].push(m);
+      }
+    }
+    for (auto v : G->getV()) ASSERT_EQ(fields[i].get(v), dist[v->id]);
+  }
+}
+
+TEST(Landmarks, admissible)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  Graph* G = P.getG();
+  auto landmarks = LibGA::Landmarks(G, 8);
+  ASSERT_EQ(landmarks.landmarks.size(), 8);
+
+  for (int i = 0; i < P.getNum(); i += 10) {
+    auto g = P.getGoal(i);
+    for (auto s : P.getConfigStart()) {
+      const int lb = landmarks.getLowerBound(s, g);
+      ASSERT_TRUE(lb >= s->manhattanDist(g));
+      ASSERT_TRUE(lb <= G->pathDist(s, g));
+    }
+  }
+}
+
+TEST(RadixHeap, monotone)
+{
+  LibGA::RadixHeap heap;
+  heap.push(5, 0);
+  heap.push(1, 1);
+  heap.push(1000, 2);
+  heap.push(3, 3);
+  ASSERT_EQ(heap.pop(), 1);
+  heap.push(2, 4);
+  ASSERT_EQ(heap.pop(), 4);
+  ASSERT_EQ(heap.pop(), 3);
+  ASSERT_EQ(heap.pop(), 0);
+  heap.push(7, 5);
+  ASSERT_EQ(heap.pop(), 5);
+  ASSERT_EQ(heap.pop(), 2);
+  ASSERT_TRUE(heap.empty());
+}
+
+TEST(Transport, min_cost)
+{
+  // cheapest first is not optimal, 1 + 3 + 10 > 3 + 3 + 1
+  std::vector<int> supply = {2, 1};
+  std::vector<int> demand = {1, 2};
+  std::vector<int> cost = {1, 3, 1, 10};
+  auto flow = LibGA::Transport::solve(supply, demand, cost);
+  ASSERT_EQ(flow, std::vector<int>({0, 2, 1, 0}));
+}
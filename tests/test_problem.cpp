@@ -49,3 +49,58 @@ TEST(Problem, plan)
   plan1.add(c2_1);
   ASSERT_FALSE(plan2.validate(&P));
 }
+
+TEST(Problem, stream_plan)
+{
+  Problem P = Problem("../tests/instances/01.txt");
+  Graph* G = P.getG();
+
+  Plan plan;
+  plan.setWriter(std::make_shared<PlanWriter>(&P));
+  plan.add({G->getNode(0, 0), G->getNode(1, 1)});
+  plan.add({G->getNode(1, 0), G->getNode(0, 1)});
+
+  // read only after flush, which is explicit
+  plan.flush();
+  ASSERT_EQ(plan.size(), 2);
+  ASSERT_EQ(plan.getSOC(), 2);
+  ASSERT_TRUE(plan.validate(&P));
+  ASSERT_TRUE(plan.validate(&P));
+  ASSERT_FALSE(plan.empty());
+}
+
+TEST(Problem, block)
+{
+  Problem P = Problem("../tests/instances/01.txt");
+  Graph* G = P.getG();
+  Node* v = G->getNode(1, 1);
+  Node* u = G->getNode(1, 0);
+  const int degree = v->getDegree();
+  const Nodes v_neighbors = v->neighbor;
+  const Nodes u_neighbors = u->neighbor;
+
+  P.blockNode(v);
+  ASSERT_TRUE(P.isBlocked(v));
+  ASSERT_EQ(v->getDegree(), 0);
+  ASSERT_FALSE(inArray(v, u->neighbor));
+
+  // neighbors blocked together are reconnected
+  P.blockNode(u);
+  P.unblockNode(v);
+  ASSERT_FALSE(P.isBlocked(v));
+  ASSERT_EQ(v->getDegree(), degree - 1);
+  P.unblockNode(u);
+  ASSERT_EQ(v->getDegree(), degree);
+  ASSERT_TRUE(inArray(v, u->neighbor));
+  ASSERT_TRUE(P.getBlockedNodes().empty());
+
+  // adjacency order is restored
+  ASSERT_EQ(v->neighbor, v_neighbors);
+  ASSERT_EQ(u->neighbor, u_neighbors);
+  for (auto w : v_neighbors) {
+    const Nodes w_neighbors = w->neighbor;
+    P.blockNode(v);
+    P.unblockNode(v);
+    ASSERT_EQ(w->neighbor, w_neighbors);
+  }
+}
@@ -1,3 +1,6 @@
+#include <fstream>
+#include <queue>
+#include <sstream>
 #include <tswap.hpp>
 
 #include "gtest/gtest.h"
@@ -21,3 +24,167 @@ TEST(TSWAP, deadlock)
   ASSERT_TRUE(solver->succeed());
   ASSERT_TRUE(solver->getSolution().validate(&P));
 }
+
+TEST(TSWAP, anytime)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  std::unique_ptr<TSWAP> solver = std::make_unique<TSWAP>(&P);
+
+  char argv0[] = "dummy";
+  char argv1[] = "-A";
+  char argv2[] = "3";
+  char* argv[] = {argv0, argv1, argv2};
+  solver->setParams(3, argv);
+  solver->solve();
+
+  ASSERT_TRUE(solver->succeed());
+  auto plan = solver->getSolution();
+  ASSERT_TRUE(plan.validate(&P));
+
+  // goals are handed over after the interim steps at the latest
+  ASSERT_TRUE(solver->getTimestepImproved() > 0);
+  ASSERT_TRUE(solver->getTimestepImproved() <= 3);
+  ASSERT_TRUE(permutatedConfig(plan.last(), P.getConfigGoal()));
+}
+
+TEST(TSWAP, map_edits)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  std::unique_ptr<Solver> solver = std::make_unique<TSWAP>(&P);
+
+  char argv0[] = "dummy";
+  char argv1[] = "-e";
+  char argv2[] = "../tests/instances/08_edits.txt";
+  char* argv[] = {argv0, argv1, argv2};
+  solver->setParams(3, argv);
+  solver->solve();
+
+  ASSERT_TRUE(solver->succeed());
+  auto plan = solver->getSolution();
+  ASSERT_TRUE(plan.validate(&P));
+  ASSERT_TRUE(P.getBlockedNodes().empty());
+
+  // blocked nodes are not used, from the timestep of blocking to that of
+  // unblocking or the end; occupied nodes and goals are not blocked
+  std::ifstream file(argv2);
+  std::string line;
+  std::unordered_map<Node*, int> blocked_from;
+  std::vector<std::tuple<Node*, int, int>> intervals;
+  while (getline(file, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    int t, x, y, b;
+    ASSERT_EQ(std::sscanf(line.c_str(), "%d,%d,%d,%d", &t, &x, &y, &b), 4);
+    auto v = P.getG()->getNode(x, y);
+    if (b == 1) {
+      if (inArray(v, plan.get(t)) || inArray(v, P.getConfigGoal())) continue;
+      blocked_from[v] = t;
+    } else if (blocked_from.find(v) != blocked_from.end()) {
+      intervals.emplace_back(v, blocked_from[v], t);
+      blocked_from.erase(v);
+    }
+  }
+  for (auto& [v, t] : blocked_from)
+    intervals.emplace_back(v, t, plan.getMakespan());
+  ASSERT_FALSE(intervals.empty());
+  for (auto& [v, t_from, t_to] : intervals) {
+    for (int t = t_from; t <= std::min(t_to, plan.getMakespan()); ++t)
+      ASSERT_FALSE(inArray(v, plan.get(t)));
+  }
+}
+
+TEST(TSWAP, parallel_planning)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  std::unique_ptr<Solver> solver_serial = std::make_unique<TSWAP>(&P);
+  solver_serial->solve();
+  auto plan_serial = solver_serial->getSolution();
+
+  char argv0[] = "dummy";
+  char argv1[] = "-p";
+  char argv2[] = "4";
+  char argv3[] = "-D";
+  char* argv[] = {argv0, argv1, argv2, argv3};
+
+  // same as the serial plan
+  std::unique_ptr<Solver> solver_deterministic = std::make_unique<TSWAP>(&P);
+  solver_deterministic->setParams(4, argv);
+  solver_deterministic->solve();
+  auto plan = solver_deterministic->getSolution();
+  ASSERT_TRUE(solver_deterministic->succeed());
+  ASSERT_EQ(plan.size(), plan_serial.size());
+  for (int t = 0; t < plan.size(); ++t)
+    ASSERT_EQ(plan.get(t), plan_serial.get(t));
+
+  std::unique_ptr<Solver> solver = std::make_unique<TSWAP>(&P);
+  solver->setParams(3, argv);
+  solver->solve();
+  ASSERT_TRUE(solver->succeed());
+  ASSERT_TRUE(solver->getSolution().validate(&P));
+}
+
+TEST(TSWAP, stream_plan)
+{
+  Problem P = Problem("../tests/instances/08.txt");
+  std::unique_ptr<Solver> solver = std::make_unique<TSWAP>(&P);
+  solver->solve();
+  auto plan = solver->getSolution();
+
+  char argv0[] = "dummy";
+  char argv1[] = "-W";
+  char* argv[] = {argv0, argv1};
+  std::unique_ptr<Solver> solver_stream = std::make_unique<TSWAP>(&P);
+  solver_stream->setParams(2, argv);
+  solver_stream->solve();
+  auto plan_stream = solver_stream->getSolution();
+
+  ASSERT_TRUE(solver_stream->succeed());
+  ASSERT_TRUE(plan_stream.streamed());
+  ASSERT_TRUE(plan_stream.validate(&P));
+  ASSERT_EQ(plan_stream.getSOC(), plan.getSOC());
+  ASSERT_EQ(plan_stream.getMakespan(), plan.getMakespan());
+
+  // written in the same format
+  std::stringstream ss, ss_stream;
+  plan.write(ss);
+  plan_stream.write(ss_stream);
+  ASSERT_EQ(ss_stream.str(), ss.str());
+}
+
+TEST(TSWAP, agent_queue)
+{
+  // same order as the heap, with pushes similar to planning
+  using AgentKey = std::tuple<int, bool, int>;  // called, at goal, +-index
+  std::priority_queue<AgentKey, std::vector<AgentKey>, std::greater<AgentKey>>
+      H;
+  TSWAP::AgentQueue U;
+  std::mt19937 MT(0);
+  const int N = 500;
+  std::vector<int> called(N, 0);
+  std::vector<bool> queued(N, false);
+  auto push = [&](const int i) {
+    const bool at_goal = getRandomBoolean(&MT);
+    H.emplace(called[i], at_goal, at_goal ? -i : i);
+    U.push(i, called[i], at_goal);
+    queued[i] = true;
+  };
+
+  for (int i = 0; i < N; ++i) push(i);
+  while (!H.empty()) {
+    ASSERT_FALSE(U.empty());
+    auto [c, at_goal, k] = H.top();
+    H.pop();
+    const int i = at_goal ? -k : k;
+    ASSERT_EQ(U.pop(), i);
+    queued[i] = false;
+    ++called[i];
+    if (called[i] < 5 && getRandomInt(0, 2, &MT) > 0) push(i);
+
+    // out of index order, also to the current bucket
+    const int j = getRandomInt(0, N - 1, &MT);
+    if (!queued[j] && getRandomInt(0, 9, &MT) == 0) {
+      called[j] = c + getRandomInt(0, 1, &MT);
+      push(j);
+    }
+  }
+  ASSERT_TRUE(U.empty());
+}
@@ -0,0 +1,57 @@
+/*
+ * all-pairs distances of one map, precomputed once and memory-mapped
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "graph.hpp"
+
+class DistanceOracle
+{
+private:
+  static constexpr uint64_t MAGIC = 0x4c43524f50415753;  // "SWAPORCL"
+  static constexpr uint32_t VERSION = 1;
+  static constexpr uint16_t UNREACHABLE = UINT16_MAX;
+
+  struct Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t nodes_num;  // number of existing nodes
+    uint64_t map_hash;
+    char map_file[256];  // for information
+  };
+
+  Graph* G;
+  const int inf;            // returned for unreachable pairs
+  std::vector<int> compact;  // node id -> index in the table
+  int nodes_num;
+
+  // memory-mapped file
+  void* data;
+  size_t data_size;
+  const uint16_t* table;  // table[goal * nodes_num + start]
+
+  static std::vector<int> getCompactIndexes(Graph* G, int& nodes_num);
+
+public:
+  DistanceOracle(Graph* _G, const std::string& file);
+  ~DistanceOracle();
+
+  // structure of the grid, an oracle is valid only for the same hash
+  static uint64_t getMapHash(Graph* G);
+
+  // precompute all-pairs distances by BFS from every node
+  static void build(Graph* G, const std::string& file,
+                    const int num_threads = 1);
+
+  int get(Node* const s, Node* const g) const
+  {
+    const uint16_t d =
+        table[(size_t)compact[g->id] * nodes_num + compact[s->id]];
+    return (d == UNREACHABLE) ? inf : d;
+  }
+};
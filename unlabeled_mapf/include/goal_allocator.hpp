@@ -1,10 +1,13 @@
 // target assignment with lazy evaluation
 
 #pragma once
+#include <atomic>
 #include <queue>
 
+#include "distance_oracle.hpp"
 #include "lib_ga.hpp"
 #include "problem.hpp"
+#include "thread_pool.hpp"
 
 class GoalAllocator
 {
@@ -18,47 +21,202 @@ public:
     GREEDY_SWAP,
     GREEDY_SWAP_WO_LAZY,
     GREEDY_SWAP_COST,
+    BOTTLENECK_LINEAR_AUCTION,
+    HIERARCHICAL,
+    LINEAR_SPARSE,
   };
 
 private:
   Problem* P;
+  Config starts;          // current starts, changed by the incremental API
+  Config goals;           // current goals, changed by the incremental API
   Nodes assigned_goals;   // start index -> goal
   Nodes assigned_starts;  // goal index -> start
 
   const MODE assignment_mode;
 
+  // use bit-parallel BFS to compute all start-goal distances from this size
+  static constexpr int MULTI_SOURCE_BFS_MIN_AGENTS = 128;
+
+  // initial number of nearest goals connected to each start in sparse linear
+  // assignment, doubled while no perfect matching exists
+  static constexpr int LINEAR_CANDIDATES = 8;
+
+  // square regions of hierarchical assignment, in cells
+  static constexpr int REGION_WIDTH = 64;
+
+  // neighbors of changed pairs considered in incremental repair,
+  // and nearest starts and goals of each pair as candidates
+  static constexpr int REPAIR_HOPS = 2;
+  static constexpr int REPAIR_CANDIDATES = 16;
+
+  // initial radius of starts around each goal in greedy assignment with the
+  // oracle, doubled when they are used up
+  static constexpr int ORACLE_RADIUS = 8;
+
+  // used for independent per-goal computation
+  std::unique_ptr<ThreadPool> pool;
+
+  // acceptable suboptimality of the auction, 0 -> optimal
+  double auction_gap;
+
+  // match all pairs of one distance level at once in bottleneck assignment
+  bool level_batch;
+
+  // check all pairs in greedy refinement instead of nearby ones
+  bool refine_exhaustive;
+
   // qualities
   int matching_cost;      // estimation of sum of costs
   int matching_makespan;  // estimation of makspan
 
   // lazy evaluation
   std::vector<std::queue<Node*>> OPEN_LAZY;
-  std::vector<std::vector<int>> DIST_LAZY;
+  std::vector<LibGA::DistanceField> DIST_LAZY;  // tiles are allocated on demand
+
+  // precomputed distances, used instead of BFS when available
+  std::shared_ptr<DistanceOracle> oracle;
+
+  // fields of goals taken over from and returned to other problems,
+  // the cache is consulted once per goal before its BFS starts
+  std::shared_ptr<LibGA::FieldCache> field_cache;
+  uint64_t map_hash;
+  std::vector<char> field_fetched;  // goal index -> cache consulted
+  void fetchField(const int j);
+  void releaseField(const int j);  // check in the field to the cache
+
+  // lower bounds for lazy evaluation, nullptr -> Manhattan distance
+  std::shared_ptr<LibGA::Landmarks> landmarks;
+  int lazy_eval_avoided;  // BFS evaluations avoided thanks to landmarks
+
+  int getLowerBound(Node* const s, Node* const g) const;
+
+  // lazy evaluation by reverse-resumable A* instead of BFS,
+  // distances already found by BFS are used as they are
+  bool resumable_astar;
+  bool astar_wide;  // entries of the searches
+  std::vector<std::unique_ptr<LibGA::ResumableAstar>> ASTAR_LAZY;
+
+  // next hops toward goals, built from finished BFS when queried first
+  bool next_hop;
+  std::vector<std::unique_ptr<LibGA::NextHopField>> NEXT_HOP_LAZY;
+  std::atomic<uint64_t> lazy_eval_expanded;  // nodes expanded by lazy eval
+
+  // set by cancel() from another thread, checked by assign() between BFS
+  // levels and phases
+  std::atomic<bool> cancelled;
+
+  // incremental updates, agent index -> goal index and its inverse,
+  // kept after the first assignment
+  bool assigned;
+  std::vector<int> agent_goal;
+  std::vector<int> goal_agent;
+  std::vector<bool> goal_changed;  // pairs to be repaired by reassign()
+
+  int getNum() const { return goals.size(); }
+  void setAgentGoals();           // from assigned_goals
+  void repairByCycleCanceling(const int hops);  // around changed pairs
 
 public:
+  // safe to call concurrently as long as the goals differ
   int getLazyEval(const int start_index, const int goal_index);
   int getLazyEval(Node* const s, const int goal_index);
 
+  // first neighbor of s with a smaller distance to the goal, s itself when
+  // it has none, nullptr -> next hops are not available
+  Node* getNextHop(Node* const s, const int goal_index);
+
 private:
   void setAllStartGoalDistances();  // compute all start-goal pairs of distance
 
+  // advance BFS of the goals to discover all nodes at distance d,
+  // found[j] receives start indexes at distance d from goal j
+  void expandGoalFields(const int d, const std::vector<int>& goal_indexes,
+                        const std::vector<int>& start_indexes,
+                        std::vector<std::vector<int>>& found);
+
   void bottleneckAssign();
+  void bottleneckAssignWoLazy();
   void linearAssign();
+  void linearSparseAssign();
   void greedyAssign();
   void greedySwapAssign();
+  void greedySwapInitByOracle();  // visit starts in order of oracle distances
   void greedySwapAssignWoLazy();
+  void hierarchicalAssign();
   void greedyRefine();
   void greedyRefineSOC();
+  void greedyRefineByIndex();     // only swaps with nearby agents
+  void greedyRefineSOCByIndex();  // with a work queue of changed agents
+  void updateAssignedGoals();     // from assigned_starts
+  void updateQuality();           // from assigned_starts
 
 public:
   GoalAllocator(Problem* _P, MODE _mode = MODE::BOTTLENECK_LINEAR);
   ~GoalAllocator();
 
+  // number of threads used in precomputation, results do not depend on it
+  void setThreads(const int num_threads);
+
+  // stop the auction within (1 + gap) of the optimal sum of costs
+  void setAuctionGap(const double gap);
+
+  // update the bottleneck matching per distance level (default) or per pair,
+  // the makespan is the same but ties of BOTTLENECK might differ
+  void setLevelBatch(const bool flg);
+
+  // check all agent pairs in greedy refinement as in the original version,
+  // the spatial index finds the same swaps for the makespan (GREEDY_SWAP)
+  // and another local optimum for the sum of costs (GREEDY_SWAP_COST)
+  void setRefineExhaustive(const bool flg);
+
+  // answer distances from a precomputed oracle of the same map
+  void setOracle(std::shared_ptr<DistanceOracle> _oracle);
+
+  // take over distance fields of the goals from the cache when evaluated,
+  // they are returned to the cache when the allocator is destroyed
+  void setFieldCache(std::shared_ptr<LibGA::FieldCache> _field_cache);
+
+  // evaluate distances lazily by reverse-resumable A* toward the queried
+  // node, the search of each goal is resumed by later queries
+  void setResumableAstar(const bool flg);
+
+  // answer next hops by table lookups once the BFS of each goal is finished,
+  // 2 bits per node and goal in addition
+  void setNextHop(const bool flg);
+
+  // use landmarks of the same map instead of Manhattan distance
+  void setLandmarks(std::shared_ptr<LibGA::Landmarks> _landmarks);
+
   // solve the problem
   void assign();
 
+  // stop assign() running in another thread soon, its result is undefined
+  // and the allocator is not used anymore except for its destruction
+  void cancel();
+
+  // Incremental updates for changing goal sets. Distance fields are kept
+  // except for replaced goals, and reassign() repairs the last assignment
+  // locally from changed pairs instead of solving from scratch, i.e., the
+  // result is not always optimal. Before assign(), only the inputs change.
+  int addAgent(Node* const s, Node* const g);  // return the new index
+  void removeGoal(const int j);  // with its agent, the last ones take over
+  void replaceGoal(const int j, Node* const g);
+  void moveAgent(const int i, Node* const v);
+  void reassign();
+
+  // repair distance fields after nodes are blocked or unblocked in the
+  // graph, landmarks might be no longer admissible for unblocked nodes
+  void repairFields(const Nodes& blocked, const Nodes& unblocked);
+
   // get results
   Nodes getAssignedGoals() const;
+  Config getStarts() const;
+  Config getGoals() const;
+  int getAgentGoal(const int i) const;  // goal index, after assign()
+  int getGoalAgent(const int j) const;  // agent index, after assign()
   int getMakespan() const;
   int getCost() const;
+  int getLazyEvalAvoided() const;
+  uint64_t getLazyEvalExpanded() const;
 };
@@ -1,12 +1,24 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
 
 #include "graph.hpp"
 #include "problem.hpp"
+#include "thread_pool.hpp"
 
 namespace LibGA
 {
   struct FieldEdge;
+  struct DistanceField;
+  struct Landmarks;
   struct FlowNode;
   using FlowNodes = std::vector<FlowNode*>;
 
@@ -29,18 +41,393 @@ namespace LibGA
     void setRealDist(int _d);
   };
 
+  // distance field of one goal, stored in lazily allocated square tiles
+  struct DistanceField {
+    static constexpr int TILE_BITS = 5;  // 32x32 cells per tile
+    static constexpr int TILE_WIDTH = 1 << TILE_BITS;
+    static constexpr int TILE_SIZE = TILE_WIDTH * TILE_WIDTH;
+    static constexpr uint16_t UNKNOWN_16 = UINT16_MAX;
+    static constexpr uint32_t UNKNOWN_32 = UINT32_MAX;
+
+    const int inf;      // returned for unreached nodes
+    const bool wide;    // false -> 16-bit entries, true -> 32-bit entries
+    const int tiles_x;  // number of tiles in one row
+
+    // untouched tiles refer to a shared read-only tile filled with UNKNOWN
+    std::vector<uint16_t*> tiles_16;
+    std::vector<uint32_t*> tiles_32;
+    std::vector<std::unique_ptr<uint16_t[]>> allocated_16;
+    std::vector<std::unique_ptr<uint32_t[]>> allocated_32;
+
+    DistanceField(Grid* grid, const int _inf, const bool _wide);
+
+    // whether 16-bit entries are insufficient for the grid
+    static bool requireWide(Graph* G);
+
+    int get(Node* const v) const
+    {
+      const int t = tileIndex(v);
+      const int k = cellIndex(v);
+      if (wide) {
+        const uint32_t d = tiles_32[t][k];
+        return (d == UNKNOWN_32) ? inf : d;
+      }
+      const uint16_t d = tiles_16[t][k];
+      return (d == UNKNOWN_16) ? inf : d;
+    }
+
+    void set(Node* const v, const int d)
+    {
+      const int t = tileIndex(v);
+      const int k = cellIndex(v);
+      if (wide) {
+        if (tiles_32[t] == EMPTY_TILE_32) allocateTile(t);
+        tiles_32[t][k] = d;
+      } else {
+        if (tiles_16[t] == EMPTY_TILE_16) allocateTile(t);
+        tiles_16[t][k] = d;
+      }
+    }
+
+    // number of bytes used by allocated tiles
+    size_t getMemoryUsage() const;
+
+    // forget all distances and release tiles
+    void clear();
+
+    // exchange contents with a field of the same grid
+    void swap(DistanceField& other);
+
+    // forget the distance of one node
+    void reset(Node* const v)
+    {
+      if (get(v) != inf) set(v, wide ? UNKNOWN_32 : UNKNOWN_16);
+    }
+
+    // Repair a lazy BFS from the goal with its open list after nodes are
+    // blocked or unblocked, i.e., isolated from or reconnected to their
+    // neighbors. Only nodes whose distances change are touched, known
+    // distances stay exact and the BFS can be resumed from the open list.
+    void repair(Grid* grid, Node* const g, std::queue<Node*>& open,
+                const Nodes& blocked, const Nodes& unblocked);
+
+  private:
+    int tileIndex(Node* const v) const
+    {
+      return (v->pos.y >> TILE_BITS) * tiles_x + (v->pos.x >> TILE_BITS);
+    }
+    static int cellIndex(Node* const v)
+    {
+      return ((v->pos.y & (TILE_WIDTH - 1)) << TILE_BITS) |
+             (v->pos.x & (TILE_WIDTH - 1));
+    }
+    void allocateTile(const int t);
+
+    static uint16_t* const EMPTY_TILE_16;
+    static uint32_t* const EMPTY_TILE_32;
+  };
+
+  // Process-wide LRU cache of distance fields of goals with their BFS open
+  // lists, keyed by the map and the goal cell, so that problems on the same
+  // map reuse BFS of earlier ones, e.g., a sweep over agent numbers. A field
+  // is checked out by one allocator at a time and checked in when released,
+  // least recently checked-in fields are evicted beyond the capacity.
+  struct FieldCache {
+    static constexpr size_t DEFAULT_CAPACITY = (size_t)1 << 30;  // bytes
+
+  private:
+    struct Entry {
+      uint64_t map_hash;
+      int goal_id;
+      DistanceField field;
+      std::vector<int> open;  // node ids, valid for other grids of the map
+      size_t memory_usage;
+      Entry(Graph* G, const uint64_t _map_hash, const int _goal_id);
+    };
+    using Entries = std::list<std::unique_ptr<Entry>>;  // recent first
+
+    struct KeyHash {
+      size_t operator()(const std::pair<uint64_t, int>& key) const
+      {
+        return key.first ^ ((uint64_t)key.second * 0x9e3779b97f4a7c15);
+      }
+    };
+
+    mutable std::mutex mtx;
+    size_t capacity;
+    size_t memory_usage;
+    Entries entries;
+    std::unordered_map<std::pair<uint64_t, int>, Entries::iterator, KeyHash>
+        table;  // (map hash, goal node id) -> entry
+
+    // counters
+    uint64_t hit_cnt;
+    uint64_t miss_cnt;
+    uint64_t eviction_cnt;
+
+    void evict();  // until the memory usage is within the capacity
+
+  public:
+    FieldCache(const size_t _capacity = DEFAULT_CAPACITY);
+
+    // shared by all users in the process
+    static std::shared_ptr<FieldCache> getShared();
+
+    void setCapacity(const size_t _capacity);  // in bytes
+
+    // move the field of the goal into the given one, false if not cached
+    bool checkOut(Graph* G, const uint64_t map_hash, Node* const g,
+                  DistanceField& field, std::queue<Node*>& open);
+
+    // move the given field into the cache, the former one is replaced
+    void checkIn(Graph* G, const uint64_t map_hash, Node* const g,
+                 DistanceField& field, std::queue<Node*>& open);
+
+    size_t size() const;
+    size_t getMemoryUsage() const;
+    uint64_t getHits() const;
+    uint64_t getMisses() const;
+    uint64_t getEvictions() const;
+  };
+
+  // BFS from a batch of goals at once, each cell keeps one bit per goal.
+  // Each goal stops at the level where all targets are reached, leaving the
+  // same state as the lazy BFS, i.e., distances up to that level and the
+  // cells of that level in the open list.
+  struct MultiSourceBFS {
+#ifdef __AVX2__
+    static constexpr int WORDS = 4;
+#else
+    static constexpr int WORDS = 1;
+#endif
+    static constexpr int BATCH_SIZE = 64 * WORDS;
+    using Bits = std::array<uint64_t, WORDS>;
+
+    static void run(Graph* G, const Nodes& goals, const Nodes& targets,
+                    const std::vector<DistanceField*>& fields,
+                    const std::vector<std::queue<Node*>*>& opens);
+  };
+
+  // admissible lower bounds of distances by the triangle inequality,
+  // |d(l, s) - d(l, g)| <= d(s, g) for each landmark l
+  struct Landmarks {
+    Graph* G;
+    const int inf;      // unreachable
+    const int K;        // number of landmarks
+    Nodes landmarks;    // well-spread nodes
+    std::vector<int> dist;  // dist[v->id * K + k] = d(landmark k, v)
+
+    Landmarks(Graph* _G, const int _K);
+
+    // also bounded by the Manhattan distance
+    int getLowerBound(Node* const s, Node* const g) const
+    {
+      int lb = s->manhattanDist(g);
+      const int* d_s = &dist[s->id * K];
+      const int* d_g = &dist[g->id * K];
+      for (int k = 0; k < K; ++k) {
+        if (d_s[k] == inf && d_g[k] == inf) continue;  // other component
+        lb = std::max(lb, std::abs(d_s[k] - d_g[k]));
+      }
+      return lb;
+    }
+  };
+
+  // Reverse-resumable A* from a goal, ordered by the distance plus the
+  // Manhattan distance to the queried node. Closed nodes keep exact
+  // distances since the heuristic is consistent on grids, and a later query
+  // resumes from the same open list, reordered for its node.
+  struct ResumableAstar {
+    Grid* grid;
+    Node* const g;   // origin of the search
+    const int inf;   // returned for unreachable nodes
+    Node* target;    // the open list is ordered for this node
+    DistanceField field;  // 2 * distance, + 1 when closed
+
+    // bucket queue of node ids by f, f never decreases in one query since
+    // the heuristic is consistent, outdated entries are skipped when popped
+    std::vector<std::vector<int>> open;  // f - f_min -> nodes
+    int f_min;
+    int f_cur;  // index of the first non-empty bucket at most
+
+    int getF(Node* const v) const
+    {
+      return (field.get(v) >> 1) + v->manhattanDist(target);
+    }
+    void push(Node* const v);
+
+    ResumableAstar(Grid* _grid, Node* const _g, const int _inf,
+                   const bool _wide);
+
+    // whether 16-bit entries are insufficient for the grid
+    static bool requireWide(Graph* G);
+
+    // distance from the goal, expanded nodes are counted
+    int get(Node* const s, uint64_t& expanded);
+  };
+
+  // next hop toward a goal for each node, i.e., the index of its first
+  // neighbor with a smaller distance, packed in 2 bits, derived from a
+  // finished distance field
+  struct NextHopField {
+    static constexpr int MAX_DEGREE = 4;
+
+    std::vector<uint8_t> bits;  // four nodes per byte
+    std::vector<bool> unknown;  // unreachable nodes or more neighbors
+
+    // from a finished BFS
+    NextHopField(Graph* G, const DistanceField& dist);
+
+    // invalid for the goal itself, nullptr -> unknown
+    Node* get(Node* const v) const
+    {
+      if (unknown[v->id]) return nullptr;
+      const int k = (bits[v->id >> 2] >> ((v->id & 3) << 1)) & 3;
+      return v->neighbor[k];
+    }
+  };
+
+  // uniform grid of square cells over the map, storing items (e.g., agents)
+  // at nodes for neighborhood queries
+  struct SpatialIndex {
+    static constexpr int CELL_BITS = 3;  // 8x8 nodes per cell
+    static constexpr int CELL_WIDTH = 1 << CELL_BITS;
+
+    const int cells_x;  // number of cells in one row
+    const int cells_y;
+    std::vector<std::vector<int>> cells;  // cell -> items
+    std::vector<int> item_cell;           // item -> cell
+    std::vector<int> item_pos;            // item -> position in the cell
+
+    SpatialIndex(Grid* grid, const int num_items);
+
+    int getCell(Node* const v) const
+    {
+      return (v->pos.y >> CELL_BITS) * cells_x + (v->pos.x >> CELL_BITS);
+    }
+    void insert(const int item, Node* const v);
+    void erase(const int item);
+    void move(const int item, Node* const v);
+
+    // f(cell, lower bound of the Manhattan distance from v) for cells within
+    // distance r
+    template <typename F>
+    void forEachCell(Node* const v, const int r, F f) const
+    {
+      const int x_min = std::max(0, v->pos.x - r) >> CELL_BITS;
+      const int x_max = std::min(cells_x * CELL_WIDTH - 1, v->pos.x + r) >>
+                        CELL_BITS;
+      const int y_min = std::max(0, v->pos.y - r) >> CELL_BITS;
+      const int y_max = std::min(cells_y * CELL_WIDTH - 1, v->pos.y + r) >>
+                        CELL_BITS;
+      for (int y = y_min; y <= y_max; ++y) {
+        const int dy = std::max({0, (y << CELL_BITS) - v->pos.y,
+                                 v->pos.y - ((y + 1) << CELL_BITS) + 1});
+        for (int x = x_min; x <= x_max; ++x) {
+          const int dx = std::max({0, (x << CELL_BITS) - v->pos.x,
+                                   v->pos.x - ((x + 1) << CELL_BITS) + 1});
+          if (dx + dy > r) continue;
+          f(y * cells_x + x, dx + dy);
+        }
+      }
+    }
+
+    // f(item) for items in cells within distance r, items are not filtered
+    template <typename F>
+    void query(Node* const v, const int r, F f) const
+    {
+      forEachCell(v, r, [&](const int cell, const int) {
+        for (auto item : cells[cell]) f(item);
+      });
+    }
+  };
+
+  // monotone priority queue of non-negative integer keys, i.e., pushed keys
+  // are not less than the last popped one, as in Dijkstra
+  struct RadixHeap {
+    static constexpr int BUCKETS = 33;
+    // bucket i > 0 holds keys whose highest differing bit from last is i - 1
+    std::array<std::vector<std::pair<uint32_t, int>>, BUCKETS> buckets;
+    uint32_t last = 0;  // last popped key
+    size_t size = 0;
+
+    int getBucket(const uint32_t key) const
+    {
+      return key == last ? 0 : 32 - __builtin_clz(key ^ last);
+    }
+    void push(const uint32_t key, const int value);
+    int pop();  // value with the minimum key
+    bool empty() const { return size == 0; }
+    void clear();
+  };
+
+  // min-cost transportation between A sources and B sinks with the same
+  // total amount, successive shortest paths with dense Dijkstra.
+  // cost[a * B + b] >= 0, return flow[a * B + b]
+  struct Transport {
+    static std::vector<int> solve(const std::vector<int>& supply,
+                                  const std::vector<int>& demand,
+                                  const std::vector<int>& cost);
+  };
+
   struct Matching {
     const Nodes starts;
     const Nodes goals;
     const int N;                         // number of starts
     static constexpr int NIL = -1;       // mean empty
-    std::vector<std::vector<int>> adj;   // edges
-    std::vector<int> mate;               // pair
-    std::vector<std::vector<int>> cost;  // start -> goal
+    std::vector<int> mate;  // pair
     int matched_num;
     Nodes assigned_goals;  // results
 
+    // edges in flat arrays over starts [0, N) and goals [N, 2N), each edge
+    // is stored twice as arcs. Arcs [0, C) are compacted by node (CSR),
+    // recent arcs are C + k linked per node, and merged when they grow.
+    // Costs are kept per arc, only for added edges.
+    std::vector<int> csr_begin;   // node -> first compacted arc
+    std::vector<int> csr_target;  // arc -> node
+    std::vector<int> csr_cost;    // arc -> cost
+    std::vector<int> recent_target;
+    std::vector<int> recent_cost;
+    std::vector<int> recent_next;
+    std::vector<int> recent_head;  // node -> first recent arc
+    std::vector<int> recent_tail;  // node -> last recent arc
+    void compactEdges();
+
+    int firstArc(const int v) const
+    {
+      if (csr_begin[v] < csr_begin[v + 1]) return csr_begin[v];
+      return recent_head[v] == NIL ? NIL : csr_target.size() + recent_head[v];
+    }
+    int nextArc(const int v, const int a) const
+    {
+      const int C = csr_target.size();
+      if (a < C) {
+        if (a + 1 < csr_begin[v + 1]) return a + 1;
+        return recent_head[v] == NIL ? NIL : C + recent_head[v];
+      }
+      return recent_next[a - C] == NIL ? NIL : C + recent_next[a - C];
+    }
+    int getArcHead(const int a) const
+    {
+      const int C = csr_target.size();
+      return a < C ? csr_target[a] : recent_target[a - C];
+    }
+    int getArcCost(const int a) const
+    {
+      const int C = csr_target.size();
+      return a < C ? csr_cost[a] : recent_cost[a - C];
+    }
+    int getEdgeCost(const int s, const int g) const;  // NIL if not added
+
+    // for searches, marks are valid only when stamped with the current epoch
+    int epoch;
+    std::vector<int> visited;      // node -> epoch
+    std::vector<int> layer;        // start -> BFS layer
+    std::vector<int> current_arc;  // node -> next arc to be examined
+    std::vector<int> stack;
+
     Matching(Problem* P);
+    Matching(const Nodes& _starts, const Nodes& _goals);
 
     void addEdge(FieldEdge const* e);
     void resetCurrentMate();
@@ -48,10 +435,32 @@ namespace LibGA
     int getCost();
     int getMakespan();
 
-    // find one augmenting path
+    // find one augmenting path through the new edge
     void updateByIncrementalFordFulkerson(FieldEdge const* e);
 
+    // augment the current matching to a maximum one by Hopcroft-Karp,
+    // e.g., after adding edges of one distance level by addEdge
+    void updateByHopcroftKarp();
+
+    // search an alternating path from the unmatched node v, then flip it
+    bool augment(const int v);
+
     // successive shortest path algorithm
     void solveBySuccessiveShortestPath();
+
+    // start from the current matching and cancel negative cycles in the
+    // residual graph found by SPFA, until the matching is min-cost among
+    // those of the same size. The final labels are feasible potentials,
+    // an edge (s, g) added later keeps the optimality when its cost is at
+    // least potential[g] - potential[s].
+    std::vector<int> potential;
+    void solveByCycleCanceling();
+
+    // forward/reverse auction with epsilon scaling, bids are computed in
+    // parallel (Jacobi style) and resolved in a fixed order.
+    // Stop when the sum of costs is within (1 + gap) of the dual lower bound,
+    // gap = 0 -> optimal.
+    static constexpr int AUCTION_EPS_FACTOR = 6;  // epsilon reduction
+    void solveByAuction(ThreadPool* pool, const double gap = 0);
   };
 };  // namespace LibGA
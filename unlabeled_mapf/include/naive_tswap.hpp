@@ -11,6 +11,7 @@ class NaiveTSWAP : public Solver
 public:
   static const std::string SOLVER_NAME;
   GoalAllocator::MODE assignment_mode;
+  int num_threads;  // used in target assignment
 
 private:
   struct Agent {
@@ -1,4 +1,7 @@
 #pragma once
+#include <memory>
+
+#include "plan_writer.hpp"
 #include "problem.hpp"
 
 /*
@@ -9,6 +12,9 @@ struct Plan {
 private:
   Configs configs;  // main
 
+  // configurations are streamed instead of being stored, nullptr -> not used
+  std::shared_ptr<PlanWriter> writer;
+
 public:
   ~Plan() {}
 
@@ -45,6 +51,18 @@ public:
 
   // check the plan is valid or not
   bool validate(Problem* P) const;
+
+  // stream configurations added afterward to a temporary file, only the
+  // metrics and validity are kept, get() and last() are not available
+  void setWriter(std::shared_ptr<PlanWriter> _writer);
+  bool streamed() const { return writer != nullptr; }
+
+  // wait until streamed configurations are written, configurations cannot be
+  // added afterward; a streamed plan is read, e.g., size(), only after this
+  void flush();
+
+  // write configurations in the format of result files
+  void write(std::ostream& os) const;
 };
 
 using Plans = std::vector<Plan>;
@@ -0,0 +1,73 @@
+/*
+ * streaming configurations of a plan into a temporary file
+ */
+
+#pragma once
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "problem.hpp"
+
+// Configurations are copied into a bounded ring buffer and a writer thread
+// drains them into a temporary file in the format of result files, checking
+// the plan and aggregating its metrics on the way. Only the previous
+// configuration and per-agent or per-node states are kept in memory.
+class PlanWriter
+{
+public:
+  static constexpr int CAPACITY = 64;  // configurations in the ring buffer
+
+private:
+  Problem* const P;
+  Graph* const G;
+  const int N;  // number of agents
+
+  // ring buffer of node ids, slot = counter % CAPACITY
+  std::vector<std::vector<int>> ring;
+  int pushed;  // by the caller
+  int popped;  // by the writer thread
+  bool closed;
+  std::mutex m;
+  std::condition_variable cv_push;  // a slot becomes free
+  std::condition_variable cv_pop;   // a configuration arrives or closed
+  std::thread writer;
+
+  std::FILE* file;  // removed automatically when closed
+
+  // updated by the writer thread, read after it is joined
+  int num_configs;
+  std::vector<int> config_prev;  // node ids
+  std::vector<int> last_move;    // agent -> last timestep of moving
+  std::vector<int> agent_prev;   // node id -> agent at the last timestep
+  std::vector<int> visited;      // node id -> last timestep occupied
+  std::string error;             // the first violation, empty -> valid
+
+  // closed is written only by the caller, so the caller reads it unlocked
+  void checkClosed() const;
+
+  void loop();  // main of the writer thread
+  void check(const std::vector<int>& c);
+  void write(const std::vector<int>& c);
+
+public:
+  PlanWriter(Problem* _P);
+  ~PlanWriter();
+
+  // copy a configuration, wait while the ring buffer is full
+  void add(const Config& c);
+
+  // wait until all configurations are written, called again -> no effect
+  void close();
+
+  // after close, otherwise halt
+  int size() const;
+  int getMakespan() const { return size() - 1; }
+  int getSOC() const;
+  bool validate() const;  // the reason is printed when invalid
+  void copyTo(std::ostream& os) const;  // written lines
+};
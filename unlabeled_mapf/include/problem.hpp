@@ -2,6 +2,7 @@
 #include <graph.hpp>
 #include <random>
 #include <set>
+#include <unordered_map>
 
 #include "default_params.hpp"
 #include "util.hpp"
@@ -43,6 +44,12 @@ private:
 
   const bool instance_initialized;  // for memory manage
 
+  // nodes blocked at runtime
+  std::set<Node*> blocked_nodes;
+  // nodes touched by map edits -> their neighbors on the original map, in
+  // the original order so that unblocking restores the adjacency exactly
+  std::unordered_map<Node*, Nodes> original_neighbors;
+
   enum ScenarioType { USER_SPECIFIED, RANDOM };
 
   // set starts and goals randomly
@@ -65,6 +72,14 @@ public:
   int getMaxCompTime() { return max_comp_time; };
   std::string getInstanceFileName() { return instance; };
 
+  // Map edits at runtime, e.g., a shelf is placed in an aisle. A blocked
+  // node is kept in the graph but isolated from its neighbors. The graph is
+  // shared with subproblems, and distances cached by the graph are stale.
+  void blockNode(Node* const v);
+  void unblockNode(Node* const v);
+  bool isBlocked(Node* const v) const;
+  Nodes getBlockedNodes() const;
+
   // used when making new instance file
   void makeScenFile(const std::string& output_file);
 };
@@ -0,0 +1,54 @@
+/*
+ * thread pool for independent tasks, with work stealing
+ */
+
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+  // task index, worker id
+  using Task = std::function<void(const int, const int)>;
+
+private:
+  // task indexes owned by one worker, [begin, end)
+  struct Range {
+    std::mutex m;
+    int begin;
+    int end;
+  };
+
+  const int num_threads;  // including the caller
+  std::vector<std::thread> workers;
+  std::vector<std::unique_ptr<Range>> ranges;
+
+  std::mutex m;
+  std::condition_variable cv_start;
+  std::condition_variable cv_finish;
+  Task const* task;  // current job
+  int generation;    // incremented by each parallelFor
+  int working;       // number of workers still running
+  bool terminated;
+
+  // main of each worker thread
+  void loop(const int worker_id);
+
+  // consume own tasks, then steal half of others' tasks
+  void work(const int worker_id);
+  bool steal(const int worker_id);
+
+public:
+  ThreadPool(const int _num_threads);
+  ~ThreadPool();
+
+  int getNumThreads() const { return num_threads; }
+
+  // call f(i, worker_id) for i = 0, ..., n-1, return after all finish
+  void parallelFor(const int n, const Task& f);
+};
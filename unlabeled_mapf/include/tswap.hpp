@@ -4,6 +4,7 @@
 
 #pragma once
 #include <memory>
+#include <new>
 
 #include "../include/goal_allocator.hpp"
 #include "solver.hpp"
@@ -13,33 +14,121 @@ class TSWAP : public Solver
 public:
   static const std::string SOLVER_NAME;
 
+  // Bucket queue of agents, with the same order as a heap of (called, at
+  // goal, index for agents not at goals, -index for agents at goals). Agents
+  // called fewer times come first, then agents not at goals by smaller index,
+  // then agents at goals by larger index. Pushes are appended, and a bucket
+  // is sorted when popped only if they were out of order.
+  class AgentQueue
+  {
+    std::vector<std::vector<int>> moving;   // called -> agents not at goals
+    std::vector<int> heads;                 // called -> first of moving
+    std::vector<std::vector<int>> staying;  // called -> agents at goals
+    std::vector<bool> sorted;               // called -> buckets are sorted
+    int called_min;  // there are no agents called fewer times
+    int num;
+
+  public:
+    AgentQueue();
+    void push(const int i, const int called, const bool at_goal);
+    int pop();
+    bool empty() const { return num == 0; }
+  };
+
 private:
-  struct Agent {
-    int id;        // id
-    Node* v_now;   // current location
-    Node* v_next;  // next location
-    Node* g;       // goal location
-    int called;    // how many times called in the queue
+  static constexpr int NIL = -1;  // no agent or no node
+
+  // heap buffer aligned to cache lines
+  template <typename T>
+  class AlignedBuffer
+  {
+    static constexpr size_t ALIGNMENT = 64;
+    T* data;
+
+  public:
+    AlignedBuffer(const size_t n)
+        : data(static_cast<T*>(::operator new(
+              n * sizeof(T), std::align_val_t(ALIGNMENT))))
+    {
+    }
+    ~AlignedBuffer() { ::operator delete(data, std::align_val_t(ALIGNMENT)); }
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    T& operator[](const size_t i) { return data[i]; }
+    const T& operator[](const size_t i) const { return data[i]; }
+  };
+
+  // states of all agents as structure of arrays, indexed by agent ids,
+  // locations are node ids
+  struct Agents {
+    // hot, used every timestep
+    AlignedBuffer<int> v_now;   // current location
+    AlignedBuffer<int> v_next;  // next location, NIL -> not decided
+    AlignedBuffer<int> g;       // goal location
+
+    // cold, used while planning
+    AlignedBuffer<int> called;  // how many times called in the queue
+    AlignedBuffer<int> u;       // desired next location toward g_u
+    AlignedBuffer<int> g_u;     // goal when u is computed, NIL -> invalid
+
+    Agents(const int num)
+        : v_now(num), v_next(num), g(num), called(num), u(num), g_u(num)
+    {
+    }
   };
-  using Agents = std::vector<Agent*>;
+  Agents A;
 
   GoalAllocator::MODE assignment_mode;
+  int num_threads;  // used in target assignment
+  std::string oracle_file;  // precomputed distances, empty -> not used
+  int num_landmarks;        // lower bounds of distances, 0 -> Manhattan
+  double auction_gap;       // acceptable suboptimality of the auction
+  bool level_batch;         // bottleneck matching per distance level
+  bool refine_exhaustive;   // greedy refinement checks all pairs
+  int anytime_steps;        // moves with interim goals, 0 -> not anytime
+  int field_cache_size;     // MB of the shared field cache, 0 -> not used
+  bool resumable_astar;     // lazy evaluation by RRA* instead of BFS
+  bool next_hop;            // next nodes by table lookups
+  bool stream_plan;         // configs are written out while planning
+  int planning_threads;     // used in path planning, 1 -> serial
+  bool planning_deterministic;  // parallel lookup only, same as serial plans
+  std::unique_ptr<ThreadPool> planning_pool;
+
+  // map edits at runtime, read from a file
+  struct MapEdit {
+    int timestep;  // applied before planning this timestep
+    Node* v;
+    bool blocked;  // true -> block, false -> unblock
+  };
+  std::string edits_file;  // empty -> not used
+  std::vector<MapEdit> edits;
+  void loadEdits();
+  std::shared_ptr<LibGA::FieldCache> field_cache;  // shared among problems
   std::shared_ptr<GoalAllocator> allocator;  // target assignment algorithm
   std::vector<int> goal_indexes;  // node-id -> goal index \in {1, ..., N}},
                                   // used with lazy distance evaluation
 
   // for log
   int elapsed_assignment;    // elapsed time for target assignment
+  int elapsed_assignment_improved;  // anytime, elapsed time for switching
+  int timestep_improved;            // anytime, 0 -> not switched
   int elapsed_pathplanning;  // elapsed time for path planing
   int estimated_makespan;    // estimated makespan according to the target
                              // assignment
   int estimated_soc;         // estimated sum-of-costs according to the target
                              // assignment
+  int lazy_eval_avoided;     // BFS evaluations avoided by landmarks
+  uint64_t lazy_eval_expanded_assignment;  // nodes expanded by lazy evaluation
+  uint64_t lazy_eval_expanded;             // including path planning
+  int map_edits;             // applied map edits
 
   Node* getNextNode(Node* a, Node* b);
+  int getDesiredNode(const int i);  // cached until the goal changes
 
   // detect and resolve deadlocks
-  bool deadlockDetectResolve(Agent* a, std::vector<Agent*>& occupied_now);
+  bool deadlockDetectResolve(const int i,
+                             const std::vector<int>& occupied_now);
 
   void run();
 
@@ -48,7 +137,13 @@ public:
   ~TSWAP();
 
   void setParams(int argc, char* argv[]);
+
+  // reuse distance fields of goals solved before on the same map
+  void setFieldCache(std::shared_ptr<LibGA::FieldCache> _field_cache);
   static void printHelp();
 
+  // anytime, timestep of switching to the improved goals, 0 -> not switched
+  int getTimestepImproved() const { return timestep_improved; }
+
   void makeLog(const std::string& logfile);
 };
@@ -0,0 +1,146 @@
+#include "../include/distance_oracle.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <queue>
+
+#include "../include/thread_pool.hpp"
+#include "../include/util.hpp"
+
+DistanceOracle::DistanceOracle(Graph* _G, const std::string& file)
+    : G(_G),
+      inf(G->getNodesSize()),
+      data(nullptr),
+      data_size(0),
+      table(nullptr)
+{
+  compact = getCompactIndexes(G, nodes_num);
+
+  const int fd = open(file.c_str(), O_RDONLY);
+  if (fd < 0) halt("oracle file " + file + " is not found.");
+  struct stat st;
+  fstat(fd, &st);
+  data_size = st.st_size;
+  if (data_size < sizeof(Header)) halt("oracle file " + file + " is broken.");
+  data = mmap(nullptr, data_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) halt("failed to map oracle file " + file);
+
+  // check consistency with the map
+  auto header = reinterpret_cast<const Header*>(data);
+  auto grid = reinterpret_cast<Grid*>(G);
+  if (header->magic != MAGIC || header->version != VERSION)
+    halt("oracle file " + file + " has an unknown format.");
+  if (header->width != (uint32_t)grid->getWidth() ||
+      header->height != (uint32_t)grid->getHeight() ||
+      header->nodes_num != (uint32_t)nodes_num ||
+      header->map_hash != getMapHash(G)) {
+    halt("oracle file " + file + " is made for another map, " +
+         std::string(header->map_file));
+  }
+  if (data_size !=
+      sizeof(Header) + (size_t)nodes_num * nodes_num * sizeof(uint16_t)) {
+    halt("oracle file " + file + " is broken.");
+  }
+  table = reinterpret_cast<const uint16_t*>(
+      reinterpret_cast<const char*>(data) + sizeof(Header));
+}
+
+DistanceOracle::~DistanceOracle()
+{
+  if (data != nullptr) munmap(data, data_size);
+}
+
+std::vector<int> DistanceOracle::getCompactIndexes(Graph* G, int& nodes_num)
+{
+  std::vector<int> indexes(G->getNodesSize(), -1);
+  nodes_num = 0;
+  for (int id = 0; id < G->getNodesSize(); ++id) {
+    if (G->getNode(id) != nullptr) indexes[id] = nodes_num++;
+  }
+  return indexes;
+}
+
+uint64_t DistanceOracle::getMapHash(Graph* G)
+{
+  // FNV-1a over nodes and their neighbors
+  uint64_t hash = 0xcbf29ce484222325;
+  auto add = [&](const uint64_t val) {
+    hash ^= val;
+    hash *= 0x100000001b3;
+  };
+  add(G->getNodesSize());
+  for (int id = 0; id < G->getNodesSize(); ++id) {
+    auto v = G->getNode(id);
+    if (v == nullptr) continue;
+    add(id);
+    for (auto m : v->neighbor) add(m->id);
+  }
+  return hash;
+}
+
+void DistanceOracle::build(Graph* G, const std::string& file,
+                           const int num_threads)
+{
+  int nodes_num;
+  auto compact = getCompactIndexes(G, nodes_num);
+  if (nodes_num >= UNREACHABLE) halt("map is too large to make an oracle");
+
+  // header
+  Header header;
+  std::memset(&header, 0, sizeof(Header));
+  auto grid = reinterpret_cast<Grid*>(G);
+  header.magic = MAGIC;
+  header.version = VERSION;
+  header.width = grid->getWidth();
+  header.height = grid->getHeight();
+  header.nodes_num = nodes_num;
+  header.map_hash = getMapHash(G);
+  std::strncpy(header.map_file, grid->getMapFileName().c_str(),
+               sizeof(header.map_file) - 1);
+
+  // the table is written through the mapped file, not held in memory
+  const size_t size =
+      sizeof(Header) + (size_t)nodes_num * nodes_num * sizeof(uint16_t);
+  const int fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) halt("failed to create oracle file " + file);
+  if (ftruncate(fd, size) != 0) halt("failed to allocate oracle file " + file);
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) halt("failed to map oracle file " + file);
+  std::memcpy(data, &header, sizeof(Header));
+  auto table = reinterpret_cast<uint16_t*>(reinterpret_cast<char*>(data) +
+                                           sizeof(Header));
+
+  // BFS from each node
+  Nodes V;
+  for (int id = 0; id < G->getNodesSize(); ++id) {
+    if (G->getNode(id) != nullptr) V.push_back(G->getNode(id));
+  }
+  ThreadPool pool(num_threads);
+  pool.parallelFor(nodes_num, [&](const int k, const int) {
+    uint16_t* row = table + (size_t)k * nodes_num;
+    std::fill(row, row + nodes_num, UNREACHABLE);
+    std::queue<Node*> OPEN;
+    row[k] = 0;
+    OPEN.push(V[k]);
+    while (!OPEN.empty()) {
+      auto n = OPEN.front();
+      OPEN.pop();
+      const uint16_t d_n = row[compact[n->id]];
+      for (auto m : n->neighbor) {
+        auto& d_m = row[compact[m->id]];
+        if (d_m != UNREACHABLE) continue;
+        d_m = d_n + 1;
+        OPEN.push(m);
+      }
+    }
+  });
+
+  msync(data, size, MS_SYNC);
+  munmap(data, size);
+}
@@ -1,28 +1,118 @@
 #include "../include/goal_allocator.hpp"
 
+#include <algorithm>
+#include <numeric>
 #include <unordered_map>
 
 GoalAllocator::GoalAllocator(Problem* _P, MODE _mode)
     : P(_P),
+      starts(P->getConfigStart()),
+      goals(P->getConfigGoal()),
       assignment_mode(_mode),
+      pool(std::make_unique<ThreadPool>(1)),
+      auction_gap(0),
+      level_batch(true),
+      refine_exhaustive(false),
       matching_cost(0),
       matching_makespan(0),
-      OPEN_LAZY(P->getNum()),
-      DIST_LAZY(P->getNum(), std::vector<int>(P->getG()->getNodesSize(),
-                                              P->getG()->getNodesSize()))
+      OPEN_LAZY(getNum()),
+      lazy_eval_avoided(0),
+      resumable_astar(false),
+      astar_wide(false),
+      ASTAR_LAZY(getNum()),
+      next_hop(false),
+      NEXT_HOP_LAZY(getNum()),
+      lazy_eval_expanded(0),
+      cancelled(false),
+      assigned(false)
 {
+  auto grid = reinterpret_cast<Grid*>(P->getG());
+  const bool wide = LibGA::DistanceField::requireWide(P->getG());
+  DIST_LAZY.reserve(getNum());
+  for (int i = 0; i < getNum(); ++i)
+    DIST_LAZY.emplace_back(grid, P->getG()->getNodesSize(), wide);
 }
 
-GoalAllocator::~GoalAllocator() {}
+GoalAllocator::~GoalAllocator()
+{
+  if (field_cache == nullptr) return;
+  for (int j = 0; j < getNum(); ++j) releaseField(j);
+}
+
+void GoalAllocator::setThreads(const int num_threads)
+{
+  pool = std::make_unique<ThreadPool>(num_threads);
+}
+
+void GoalAllocator::setAuctionGap(const double gap) { auction_gap = gap; }
+
+void GoalAllocator::setLevelBatch(const bool flg) { level_batch = flg; }
+
+void GoalAllocator::setRefineExhaustive(const bool flg)
+{
+  refine_exhaustive = flg;
+}
+
+void GoalAllocator::setOracle(std::shared_ptr<DistanceOracle> _oracle)
+{
+  oracle = _oracle;
+}
+
+void GoalAllocator::setFieldCache(
+    std::shared_ptr<LibGA::FieldCache> _field_cache)
+{
+  field_cache = _field_cache;
+  map_hash = DistanceOracle::getMapHash(P->getG());
+  field_fetched.assign(getNum(), false);
+}
+
+void GoalAllocator::fetchField(const int j)
+{
+  if (field_cache == nullptr || field_fetched[j]) return;
+  field_fetched[j] = true;
+  // BFS has already started
+  if (DIST_LAZY[j].get(goals[j]) == 0) return;
+  field_cache->checkOut(P->getG(), map_hash, goals[j], DIST_LAZY[j],
+                        OPEN_LAZY[j]);
+}
+
+void GoalAllocator::releaseField(const int j)
+{
+  // nothing to share
+  if (DIST_LAZY[j].get(goals[j]) != 0) return;
+  field_cache->checkIn(P->getG(), map_hash, goals[j], DIST_LAZY[j],
+                       OPEN_LAZY[j]);
+}
+
+void GoalAllocator::setResumableAstar(const bool flg)
+{
+  resumable_astar = flg;
+  if (flg) astar_wide = LibGA::ResumableAstar::requireWide(P->getG());
+}
+
+void GoalAllocator::setNextHop(const bool flg) { next_hop = flg; }
+
+void GoalAllocator::setLandmarks(
+    std::shared_ptr<LibGA::Landmarks> _landmarks)
+{
+  landmarks = _landmarks;
+}
+
+int GoalAllocator::getLowerBound(Node* const s, Node* const g) const
+{
+  if (landmarks != nullptr) return landmarks->getLowerBound(s, g);
+  return s->manhattanDist(g);
+}
 
 void GoalAllocator::assign()
 {
+  assigned = false;  // from scratch
   switch (assignment_mode) {
     case BOTTLENECK_LINEAR:
       bottleneckAssign();
       break;
     case BOTTLENECK_LINEAR_WO_LAZY:
-      bottleneckAssign();
+      bottleneckAssignWoLazy();
       break;
     case BOTTLENECK:
       bottleneckAssign();
@@ -42,28 +132,450 @@ void GoalAllocator::assign()
     case GREEDY_SWAP_COST:
       greedySwapAssign();
       break;
+    case BOTTLENECK_LINEAR_AUCTION:
+      bottleneckAssign();
+      break;
+    case HIERARCHICAL:
+      hierarchicalAssign();
+      break;
+    case LINEAR_SPARSE:
+      linearSparseAssign();
+      break;
     default:
       break;
   }
+
+  if (cancelled) return;
+  setAgentGoals();
+  assigned = true;
+}
+
+void GoalAllocator::cancel() { cancelled = true; }
+
+void GoalAllocator::setAgentGoals()
+{
+  const int N = getNum();
+  std::unordered_map<Node*, int> goal_indexes;
+  for (int j = 0; j < N; ++j) goal_indexes[goals[j]] = j;
+  agent_goal.resize(N);
+  goal_agent.resize(N);
+  for (int i = 0; i < N; ++i) {
+    const int j = goal_indexes[assigned_goals[i]];
+    agent_goal[i] = j;
+    goal_agent[j] = i;
+  }
+  goal_changed.assign(N, false);
+}
+
+int GoalAllocator::addAgent(Node* const s, Node* const g)
+{
+  const int i = getNum();
+  starts.push_back(s);
+  goals.push_back(g);
+  OPEN_LAZY.emplace_back();
+  DIST_LAZY.emplace_back(reinterpret_cast<Grid*>(P->getG()),
+                         P->getG()->getNodesSize(),
+                         LibGA::DistanceField::requireWide(P->getG()));
+  if (field_cache != nullptr) field_fetched.push_back(false);
+  ASTAR_LAZY.emplace_back();
+  NEXT_HOP_LAZY.emplace_back();
+  if (assigned) {
+    agent_goal.push_back(i);
+    goal_agent.push_back(i);
+    goal_changed.push_back(true);
+  }
+  return i;
+}
+
+void GoalAllocator::removeGoal(const int j)
+{
+  if (j < 0 || j >= getNum()) halt("goal allocator, invalid goal index");
+  const int last = getNum() - 1;
+  const int i = assigned ? goal_agent[j] : j;
+
+  // the last agent takes over i, first so that goal_agent[last] refers to
+  // the renumbered agent, also when the last agent itself has j
+  starts[i] = starts[last];
+  if (assigned) {
+    agent_goal[i] = agent_goal[last];
+    goal_agent[agent_goal[i]] = i;
+  }
+
+  // the last goal takes over j with its distance field
+  if (field_cache != nullptr) {
+    releaseField(j);
+    field_fetched[j] = field_fetched[last];
+    field_fetched.pop_back();
+  }
+  goals[j] = goals[last];
+  DIST_LAZY[j].swap(DIST_LAZY[last]);
+  std::swap(OPEN_LAZY[j], OPEN_LAZY[last]);
+  std::swap(ASTAR_LAZY[j], ASTAR_LAZY[last]);
+  std::swap(NEXT_HOP_LAZY[j], NEXT_HOP_LAZY[last]);
+  if (assigned) {
+    goal_agent[j] = goal_agent[last];
+    agent_goal[goal_agent[j]] = j;
+    goal_changed[j] = goal_changed[last];
+  }
+
+  goals.pop_back();
+  starts.pop_back();
+  DIST_LAZY.pop_back();
+  OPEN_LAZY.pop_back();
+  ASTAR_LAZY.pop_back();
+  NEXT_HOP_LAZY.pop_back();
+  if (assigned) {
+    agent_goal.pop_back();
+    goal_agent.pop_back();
+    goal_changed.pop_back();
+  }
+}
+
+void GoalAllocator::replaceGoal(const int j, Node* const g)
+{
+  if (j < 0 || j >= getNum()) halt("goal allocator, invalid goal index");
+  if (goals[j] == g) return;
+  if (field_cache != nullptr) {
+    releaseField(j);
+    field_fetched[j] = false;
+  }
+  goals[j] = g;
+  DIST_LAZY[j].clear();
+  std::queue<Node*>().swap(OPEN_LAZY[j]);
+  ASTAR_LAZY[j].reset();
+  NEXT_HOP_LAZY[j].reset();
+  if (assigned) goal_changed[j] = true;
+}
+
+void GoalAllocator::moveAgent(const int i, Node* const v)
+{
+  if (i < 0 || i >= getNum()) halt("goal allocator, invalid agent index");
+  starts[i] = v;
+  if (assigned) goal_changed[agent_goal[i]] = true;
+}
+
+void GoalAllocator::reassign()
+{
+  if (!assigned) {
+    assign();
+    return;
+  }
+
+  // keep the last pairs, changed ones included
+  assigned_starts.resize(getNum());
+  for (int j = 0; j < getNum(); ++j) assigned_starts[j] = starts[goal_agent[j]];
+
+  // the bottleneck first, then the sum of costs
+  switch (assignment_mode) {
+    case BOTTLENECK_LINEAR:
+    case BOTTLENECK_LINEAR_WO_LAZY:
+    case BOTTLENECK_LINEAR_AUCTION:
+    case HIERARCHICAL:
+      greedyRefineByIndex();
+      repairByCycleCanceling(REPAIR_HOPS);
+      break;
+    case BOTTLENECK:
+    case GREEDY_SWAP:
+    case GREEDY_SWAP_WO_LAZY:
+      greedyRefineByIndex();
+      break;
+    case LINEAR:
+    case LINEAR_SPARSE:
+    case GREEDY_SWAP_COST:
+      repairByCycleCanceling(REPAIR_HOPS);
+      break;
+    default:
+      break;
+  }
+
+  // agents might share nodes after incremental updates, so that goals are
+  // mapped to agents by goal_agent instead of nodes
+  assigned_goals.assign(getNum(), nullptr);
+  for (int j = 0; j < getNum(); ++j) {
+    agent_goal[goal_agent[j]] = j;
+    assigned_goals[goal_agent[j]] = goals[j];
+  }
+  goal_changed.assign(getNum(), false);
+  updateQuality();
+}
+
+void GoalAllocator::repairFields(const Nodes& blocked, const Nodes& unblocked)
+{
+  if (oracle != nullptr) {
+    halt("goal allocator, the oracle does not reflect map edits");
+  }
+  auto grid = reinterpret_cast<Grid*>(P->getG());
+  pool->parallelFor(getNum(), [&](const int j, const int) {
+    DIST_LAZY[j].repair(grid, goals[j], OPEN_LAZY[j], blocked, unblocked);
+    ASTAR_LAZY[j].reset();  // restarted when used
+    NEXT_HOP_LAZY[j].reset();
+  });
+
+  // fields are checked in for the edited map
+  if (field_cache != nullptr) map_hash = DistanceOracle::getMapHash(grid);
+}
+
+void GoalAllocator::repairByCycleCanceling(const int hops)
+{
+  const int N = getNum();
+  const int inf = P->getG()->getNodesSize();
+  auto grid = reinterpret_cast<Grid*>(P->getG());
+
+  // the makespan is not increased in bottleneck modes
+  int bound = inf;
+  if (assignment_mode != LINEAR && assignment_mode != LINEAR_SPARSE &&
+      assignment_mode != GREEDY_SWAP_COST) {
+    bound = 0;
+    for (int j = 0; j < N; ++j)
+      bound = std::max(bound, getLazyEval(assigned_starts[j], j));
+  }
+
+  // agents are identified by goal_agent, not by nodes which might be shared
+  LibGA::SpatialIndex starts_index(grid, N);
+  LibGA::SpatialIndex goals_index(grid, N);
+  for (int i = 0; i < N; ++i) {
+    starts_index.insert(i, starts[i]);
+    goals_index.insert(i, goals[i]);
+  }
+  std::vector<int> goal_of_start(N);  // start index -> goal index
+
+  // candidate pairs which can shorten pairs in the region, i.e., changed
+  // pairs and their neighbors within the hops
+  std::vector<bool> in_region(N, false);
+  std::vector<std::pair<int, int>> candidates;  // start index, goal index
+  std::vector<int> next;
+  std::vector<std::pair<int, int>> near;  // distance, index
+  auto keepNearest = [&]() {
+    if ((int)near.size() <= REPAIR_CANDIDATES) return;
+    std::nth_element(near.begin(), near.begin() + REPAIR_CANDIDATES,
+                     near.end());
+    near.resize(REPAIR_CANDIDATES);
+  };
+  auto extendRegion = [&](std::vector<int> frontier) {
+    for (int hop = 0; hop <= hops && !frontier.empty(); ++hop) {
+      next.clear();
+      for (auto j : frontier) {
+        if (in_region[j]) continue;
+        in_region[j] = true;
+        auto s_j = assigned_starts[j];
+        const int c_j = getLazyEval(s_j, j);
+        if (c_j == 0) continue;
+        near.clear();
+        starts_index.query(goals[j], c_j - 1, [&](const int i) {
+          const int d = goals[j]->manhattanDist(starts[i]);
+          if (d < c_j) near.emplace_back(d, i);
+        });
+        keepNearest();
+        for (auto [d, i] : near) {
+          candidates.emplace_back(i, j);
+          next.push_back(goal_of_start[i]);
+        }
+        near.clear();
+        goals_index.query(s_j, c_j - 1, [&](const int k) {
+          const int d = s_j->manhattanDist(goals[k]);
+          if (d < c_j) near.emplace_back(d, k);
+        });
+        keepNearest();
+        for (auto [d, k] : near) {
+          candidates.emplace_back(goal_agent[j], k);
+          next.push_back(k);
+        }
+      }
+      frontier.swap(next);
+    }
+  };
+
+  std::vector<int> changed;
+  for (int j = 0; j < N; ++j) {
+    if (goal_changed[j]) changed.push_back(j);
+  }
+
+  // repeat while canceling changes pairs, each round decreases the cost
+  while (!changed.empty()) {
+    for (int j = 0; j < N; ++j) goal_of_start[goal_agent[j]] = j;
+    for (auto j : changed) in_region[j] = false;
+    extendRegion(changed);
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+
+    auto matching = LibGA::Matching(starts, goals);
+    auto addEdge = [&](const int i, const int j, const int d) {
+      auto e = LibGA::FieldEdge(i, j, starts[i], goals[j],
+                                starts[i]->manhattanDist(goals[j]), d);
+      matching.addEdge(&e);
+    };
+    for (int j = 0; j < N; ++j) {
+      const int i = goal_agent[j];
+      addEdge(i, j, getLazyEval(i, j));
+      matching.mariage(i, N + j);
+    }
+    for (auto [i, j] : candidates) {
+      if (goal_of_start[i] == j) continue;
+      const int d = getLazyEval(i, j);
+      if (d <= bound) addEdge(i, j, d);
+    }
+    matching.solveByCycleCanceling();
+
+    changed.clear();
+    for (int j = 0; j < N; ++j) {
+      const int i = matching.mate[N + j];
+      if (i == goal_agent[j]) continue;
+      goal_agent[j] = i;
+      assigned_starts[j] = starts[i];
+      changed.push_back(j);
+    }
+  }
+}
+
+void GoalAllocator::expandGoalFields(const int d,
+                                     const std::vector<int>& goal_indexes,
+                                     const std::vector<int>& start_indexes,
+                                     std::vector<std::vector<int>>& found)
+{
+  // each BFS touches only its own goal
+  pool->parallelFor(goal_indexes.size(), [&](const int k, const int) {
+    const int j = goal_indexes[k];
+    auto& dist = DIST_LAZY[j];
+    auto& open = OPEN_LAZY[j];
+    while (!open.empty()) {
+      auto n = open.front();
+      const int d_n = dist.get(n);
+      if (d_n >= d) break;
+      open.pop();
+      for (auto m : n->neighbor) {
+        if (d_n + 1 >= dist.get(m)) continue;
+        dist.set(m, d_n + 1);
+        open.push(m);
+        const int i = start_indexes[m->id];
+        if (i != -1) found[j].push_back(i);
+      }
+    }
+  });
 }
 
 void GoalAllocator::bottleneckAssign()
 {
-  auto matching = LibGA::Matching(P);
+  auto matching = LibGA::Matching(starts, goals);
+  const int N = getNum();
+  const int inf = P->getG()->getNodesSize();
+
+  // node-id -> start index
+  std::vector<int> start_indexes(inf, -1);
+  for (int i = 0; i < N; ++i) start_indexes[starts[i]->id] = i;
+
+  // distance -> start-goal pairs, filled by BFS from goals level by level
+  std::vector<std::vector<std::pair<int, int>>> buckets;
+  auto addPair = [&](const int d, const int i, const int j) {
+    if (d >= (int)buckets.size()) buckets.resize(d + 1);
+    buckets[d].emplace_back(i, j);
+  };
+  std::vector<int> found_num(N, 0);  // goal index -> number of found starts
+
+  // setup BFS, starts evaluated beforehand are picked up here
+  for (int j = 0; j < N; ++j) {
+    fetchField(j);
+    auto g = goals[j];
+    auto& dist = DIST_LAZY[j];
+    if (dist.get(g) != 0) {
+      dist.set(g, 0);
+      OPEN_LAZY[j].push(g);
+      if (start_indexes[g->id] != -1) {
+        addPair(0, start_indexes[g->id], j);
+        ++found_num[j];
+      }
+      continue;
+    }
+    for (int i = 0; i < N; ++i) {
+      const int d = dist.get(starts[i]);
+      if (d == dist.inf) continue;
+      addPair(d, i, j);
+      ++found_num[j];
+    }
+  }
 
-  // use priority queue & lazy evaluation
+  std::vector<int> goals_active;  // goals whose BFS has to continue
+  std::vector<std::vector<int>> found(N);  // goal index -> newly found starts
+  bool perfect_matched = false;
+  for (int d = 0;; ++d) {
+    if (cancelled) return;
+
+    // discover all nodes at distance d
+    goals_active.clear();
+    for (int j = 0; j < N; ++j) {
+      if (found_num[j] < N && !OPEN_LAZY[j].empty()) goals_active.push_back(j);
+    }
+    expandGoalFields(d, goals_active, start_indexes, found);
+    for (auto j : goals_active) {
+      for (auto i : found[j]) addPair(d, i, j);
+      found_num[j] += found[j].size();
+      found[j].clear();
+    }
+
+    // no more reachable pairs
+    if (d >= (int)buckets.size()) {
+      if (goals_active.empty()) break;
+      continue;
+    }
+
+    // update matching with pairs at distance d
+    for (auto& pair : buckets[d]) {
+      auto e = LibGA::FieldEdge(pair.first, pair.second,
+                                starts[pair.first],
+                                goals[pair.second], d, d);
+      if (perfect_matched || level_batch) {  // add equal cost edges
+        matching.addEdge(&e);
+        continue;
+      }
+      matching.updateByIncrementalFordFulkerson(&e);
+      if (matching.matched_num == N) {
+        perfect_matched = true;
+        matching_makespan = d;
+      }
+    }
+    if (level_batch && !buckets[d].empty()) {
+      matching.updateByHopcroftKarp();
+      if (matching.matched_num == N) {
+        perfect_matched = true;
+        matching_makespan = d;
+      }
+    }
+    std::vector<std::pair<int, int>>().swap(buckets[d]);
+    if (perfect_matched) break;
+  }
+
+  // unreachable pairs, only with disconnected graphs
+  for (int j = 0; j < N && !perfect_matched; ++j) {
+    if (found_num[j] == N) continue;
+    for (int i = 0; i < N && !perfect_matched; ++i) {
+      if (DIST_LAZY[j].get(starts[i]) != DIST_LAZY[j].inf) continue;
+      auto e = LibGA::FieldEdge(i, j, starts[i], goals[j], inf, inf);
+      matching.updateByIncrementalFordFulkerson(&e);
+      if (matching.matched_num == N) {
+        perfect_matched = true;
+        matching_makespan = inf;
+      }
+    }
+  }
+
+  // use min cost maximum matching
+  if (assignment_mode == BOTTLENECK_LINEAR_AUCTION) {
+    matching.solveByAuction(pool.get(), auction_gap);
+  } else if (assignment_mode != BOTTLENECK) {
+    matching.solveByCycleCanceling();
+  }
+
+  assigned_goals = matching.assigned_goals;
+  matching_cost = matching.getCost();
+}
+
+void GoalAllocator::bottleneckAssignWoLazy()
+{
+  auto matching = LibGA::Matching(starts, goals);
 
   // setup priority queue
   auto compare = [](const LibGA::FieldEdge& a, const LibGA::FieldEdge& b) {
-    if (a.evaled && b.evaled) {
-      if (a.d != b.d) return a.d > b.d;
-    } else if (!a.evaled && !b.evaled) {
-      if (a.inst_d != b.inst_d) return a.inst_d > b.inst_d;
-    } else if (a.evaled && !b.evaled) {
-      if (a.d != b.inst_d) return a.d > b.inst_d;
-    } else if (!a.evaled && b.evaled) {
-      if (a.inst_d != b.d) return a.inst_d > b.d;
-    }
+    if (a.d != b.d) return a.d > b.d;
     // tie break
     if (a.start_index != b.start_index) return a.start_index < b.start_index;
     return a.g->id < b.g->id;
@@ -74,23 +586,12 @@ void GoalAllocator::bottleneckAssign()
                       decltype(compare)>
       OPEN(compare);
 
-  if (assignment_mode != MODE::BOTTLENECK_LINEAR_WO_LAZY) {
-    // lazy evaluation
-    for (int i = 0; i < P->getNum(); ++i) {
-      auto s = P->getStart(i);
-      for (int j = 0; j < P->getNum(); ++j) {
-        auto g = P->getGoal(j);
-        OPEN.emplace(i, j, s, g, s->manhattanDist(g));
-      }
-    }
-  } else {
-    // without lazy eval
-    for (int i = 0; i < P->getNum(); ++i) {
-      auto s = P->getStart(i);
-      for (int j = 0; j < P->getNum(); ++j) {
-        auto g = P->getGoal(j);
-        OPEN.emplace(i, j, s, g, s->manhattanDist(g), getLazyEval(s, j));
-      }
+  // without lazy eval
+  for (int i = 0; i < getNum(); ++i) {
+    auto s = starts[i];
+    for (int j = 0; j < getNum(); ++j) {
+      auto g = goals[j];
+      OPEN.emplace(i, j, s, g, s->manhattanDist(g), getLazyEval(s, j));
     }
   }
 
@@ -98,13 +599,6 @@ void GoalAllocator::bottleneckAssign()
     auto p = OPEN.top();
     OPEN.pop();
 
-    // lazy evaluation
-    if (!p.evaled) {
-      p.setRealDist(getLazyEval(p.s, p.goal_index));
-      OPEN.push(p);
-      continue;
-    }
-
     if (matching_makespan > 0) {  // add equal cost edges
       if (p.d <= matching_makespan) {
         matching.addEdge(&p);
@@ -119,11 +613,11 @@ void GoalAllocator::bottleneckAssign()
     }
 
     // perfect match
-    if (matching.matched_num == P->getNum()) matching_makespan = p.d;
+    if (matching.matched_num == getNum()) matching_makespan = p.d;
   }
 
   // use min cost maximum matching
-  if (assignment_mode != BOTTLENECK) matching.solveBySuccessiveShortestPath();
+  matching.solveBySuccessiveShortestPath();
 
   assigned_goals = matching.assigned_goals;
   matching_cost = matching.getCost();
@@ -131,54 +625,94 @@ void GoalAllocator::bottleneckAssign()
 
 int GoalAllocator::getLazyEval(const int start_index, const int goal_index)
 {
-  return getLazyEval(P->getStart(start_index), goal_index);
+  return getLazyEval(starts[start_index], goal_index);
 }
 
 int GoalAllocator::getLazyEval(Node* const s, const int goal_index)
 {
-  auto g = P->getGoal(goal_index);
+  auto g = goals[goal_index];
+  if (oracle != nullptr) return oracle->get(s, g);
+
+  fetchField(goal_index);
+  auto& dist = DIST_LAZY[goal_index];
+  auto& open = OPEN_LAZY[goal_index];
 
   // already evaluated
-  if (DIST_LAZY[goal_index][s->id] != P->getG()->getNodesSize())
-    return DIST_LAZY[goal_index][s->id];
+  const int d_s = dist.get(s);
+  if (d_s != dist.inf) return d_s;
+
+  if (resumable_astar) {
+    auto& astar = ASTAR_LAZY[goal_index];
+    if (astar == nullptr) {
+      astar = std::make_unique<LibGA::ResumableAstar>(
+          reinterpret_cast<Grid*>(P->getG()), g, dist.inf, astar_wide);
+    }
+    uint64_t expanded = 0;
+    const int d = astar->get(s, expanded);
+    lazy_eval_expanded += expanded;
+    return d;
+  }
 
   // initialize
-  if (DIST_LAZY[goal_index][g->id] != 0) {
-    DIST_LAZY[goal_index][g->id] = 0;
-    OPEN_LAZY[goal_index].push(g);
+  if (dist.get(g) != 0) {
+    dist.set(g, 0);
+    open.push(g);
   }
 
   // BFS
-  while (!OPEN_LAZY[goal_index].empty()) {
-    auto n = OPEN_LAZY[goal_index].front();
-    const int d_n = DIST_LAZY[goal_index][n->id];
+  uint64_t expanded = 0;
+  while (!open.empty()) {
+    auto n = open.front();
+    const int d_n = dist.get(n);
 
     // check goal condition
-    if (n == s) return d_n;
+    if (n == s) {
+      lazy_eval_expanded += expanded;
+      return d_n;
+    }
 
     // pop
-    OPEN_LAZY[goal_index].pop();
+    open.pop();
+    ++expanded;
 
     for (auto m : n->neighbor) {
-      const int d_m = DIST_LAZY[goal_index][m->id];
+      const int d_m = dist.get(m);
       if (d_n + 1 >= d_m) continue;
-      DIST_LAZY[goal_index][m->id] = d_n + 1;
-      OPEN_LAZY[goal_index].push(m);
+      dist.set(m, d_n + 1);
+      open.push(m);
     }
   }
+  lazy_eval_expanded += expanded;
 
   return P->getG()->getNodesSize();
 }
 
+Node* GoalAllocator::getNextHop(Node* const s, const int goal_index)
+{
+  if (!next_hop || oracle != nullptr) return nullptr;
+  auto& field = NEXT_HOP_LAZY[goal_index];
+  if (field == nullptr) {
+    // only from a finished BFS, it is not forced here
+    fetchField(goal_index);
+    auto& dist = DIST_LAZY[goal_index];
+    if (dist.get(goals[goal_index]) != 0 || !OPEN_LAZY[goal_index].empty())
+      return nullptr;
+    field = std::make_unique<LibGA::NextHopField>(P->getG(), dist);
+  }
+  if (s == goals[goal_index] || s->neighbor.empty()) return s;
+  return field->get(s);
+}
+
 void GoalAllocator::linearAssign()
 {
-  auto matching = LibGA::Matching(P);
+  auto matching = LibGA::Matching(starts, goals);
   setAllStartGoalDistances();
+  if (cancelled) return;
 
-  for (int i = 0; i < P->getNum(); ++i) {
-    auto s = P->getStart(i);
-    for (int j = 0; j < P->getNum(); ++j) {
-      auto g = P->getGoal(j);
+  for (int i = 0; i < getNum(); ++i) {
+    auto s = starts[i];
+    for (int j = 0; j < getNum(); ++j) {
+      auto g = goals[j];
       auto e =
           LibGA::FieldEdge(i, j, s, g, s->manhattanDist(g), getLazyEval(i, j));
       matching.addEdge(&e);
@@ -193,6 +727,130 @@ void GoalAllocator::linearAssign()
   matching_makespan = matching.getMakespan();
 }
 
+void GoalAllocator::linearSparseAssign()
+{
+  auto matching = LibGA::Matching(starts, goals);
+  const int N = getNum();
+  const int inf = P->getG()->getNodesSize();
+
+  // node-id -> start index
+  std::vector<int> start_indexes(inf, -1);
+  for (int i = 0; i < N; ++i) start_indexes[starts[i]->id] = i;
+
+  // pairs are found in increasing distance by BFS from goals level by level,
+  // each start takes the first K ones and postpones the others
+  int K = std::min(LINEAR_CANDIDATES, N);
+  std::vector<int> candidates_num(N, 0);  // start index -> edges
+  std::vector<int> bound(N, inf);  // start index -> lower bound of the rest
+  std::vector<std::vector<std::pair<int, int>>> postponed(N);  // d, goal
+  int satisfied = 0;  // starts with K edges
+  auto addPair = [&](const int d, const int i, const int j) {
+    if (candidates_num[i] >= K) {
+      postponed[i].emplace_back(d, j);
+      return;
+    }
+    auto e = LibGA::FieldEdge(i, j, starts[i], goals[j], d, d);
+    matching.addEdge(&e);
+    if (++candidates_num[i] == K) {
+      bound[i] = d;
+      ++satisfied;
+    }
+  };
+
+  // setup BFS, pairs evaluated beforehand are sorted by distance
+  std::vector<std::tuple<int, int, int>> evaluated;  // d, start, goal
+  std::vector<int> found_num(N, 0);  // goal index -> number of found starts
+  for (int j = 0; j < N; ++j) {
+    fetchField(j);
+    auto g = goals[j];
+    auto& dist = DIST_LAZY[j];
+    if (dist.get(g) != 0) {
+      dist.set(g, 0);
+      OPEN_LAZY[j].push(g);
+    }
+    for (int i = 0; i < N; ++i) {
+      const int d = dist.get(starts[i]);
+      if (d == dist.inf) continue;
+      evaluated.emplace_back(d, i, j);
+      ++found_num[j];
+    }
+  }
+  std::sort(evaluated.begin(), evaluated.end());
+  auto itr = evaluated.begin();
+
+  std::vector<int> goals_active;  // goals whose BFS has to continue
+  std::vector<std::vector<int>> found(N);  // goal index -> newly found starts
+  int d = 0;  // next level to be discovered
+  auto collect = [&]() {
+    for (; satisfied < N && !cancelled; ++d) {
+      goals_active.clear();
+      for (int j = 0; j < N; ++j) {
+        if (found_num[j] < N && !OPEN_LAZY[j].empty())
+          goals_active.push_back(j);
+      }
+      if (goals_active.empty() && itr == evaluated.end()) break;
+      expandGoalFields(d, goals_active, start_indexes, found);
+      for (; itr != evaluated.end() && std::get<0>(*itr) <= d; ++itr) {
+        addPair(std::get<0>(*itr), std::get<1>(*itr), std::get<2>(*itr));
+      }
+      for (auto j : goals_active) {
+        for (auto i : found[j]) addPair(d, i, j);
+        found_num[j] += found[j].size();
+        found[j].clear();
+      }
+    }
+  };
+
+  // enlarge candidates until a perfect matching exists
+  while (true) {
+    collect();
+    if (cancelled) return;
+    matching.updateByHopcroftKarp();
+    if (matching.matched_num == N || satisfied < N || K == N) break;
+    K = std::min(K * 2, N);
+    satisfied = 0;
+    for (int i = 0; i < N; ++i) {
+      bound[i] = inf;
+      auto rest = std::move(postponed[i]);
+      for (auto [d_i, j] : rest) addPair(d_i, i, j);
+    }
+  }
+  if (matching.matched_num < N) {
+    halt("goal allocator, no perfect matching");
+  }
+
+  // min-cost on the sparse graph, then verify the optimality by reduced
+  // costs, only pairs possibly violating them are evaluated and added
+  std::vector<int> goal_order(N);
+  std::iota(goal_order.begin(), goal_order.end(), 0);
+  while (!cancelled) {
+    matching.solveByCycleCanceling();
+    auto& potential = matching.potential;
+    std::sort(goal_order.begin(), goal_order.end(), [&](int j, int k) {
+      return potential[N + j] > potential[N + k];
+    });
+    bool added = false;
+    for (int i = 0; i < N; ++i) {
+      if (bound[i] == inf) continue;  // all reachable goals are connected
+      for (auto j : goal_order) {
+        const int c_min = potential[N + j] - potential[i];
+        if (c_min <= bound[i]) break;
+        if (matching.getEdgeCost(i, N + j) != LibGA::Matching::NIL) continue;
+        const int c = getLazyEval(i, j);
+        if (c >= c_min) continue;
+        auto e = LibGA::FieldEdge(i, j, starts[i], goals[j], c, c);
+        matching.addEdge(&e);
+        added = true;
+      }
+    }
+    if (!added) break;
+  }
+
+  assigned_goals = matching.assigned_goals;
+  matching_cost = matching.getCost();
+  matching_makespan = matching.getMakespan();
+}
+
 void GoalAllocator::greedyAssign()
 {
   setAllStartGoalDistances();
@@ -200,10 +858,10 @@ void GoalAllocator::greedyAssign()
   // create start-goal paris
   using Edge = std::tuple<int, Node*, int>;  // start, goal, distance
   std::vector<Edge> start_goal_pairs;
-  for (int i = 0; i < P->getNum(); ++i) {
-    for (int j = 0; j < P->getNum(); ++j) {
+  for (int i = 0; i < getNum(); ++i) {
+    for (int j = 0; j < getNum(); ++j) {
       start_goal_pairs.push_back(
-          std::make_tuple(i, P->getGoal(j), getLazyEval(i, j)));
+          std::make_tuple(i, goals[j], getLazyEval(i, j)));
     }
   }
 
@@ -222,7 +880,7 @@ void GoalAllocator::greedyAssign()
   // initialize
   std::vector<bool> goal_indexes_assigned(P->getG()->getNodesSize(), false);
   assigned_goals.clear();
-  for (int i = 0; i < P->getNum(); ++i) assigned_goals.push_back(nullptr);
+  for (int i = 0; i < getNum(); ++i) assigned_goals.push_back(nullptr);
   matching_cost = 0;
   matching_makespan = 0;
 
@@ -247,13 +905,24 @@ void GoalAllocator::greedyAssign()
 
 void GoalAllocator::greedySwapAssign()
 {
-  // initialize
+  if (oracle != nullptr) {
+    greedySwapInitByOracle();
+    if (assignment_mode == GREEDY_SWAP) {
+      greedyRefine();
+    } else if (assignment_mode == GREEDY_SWAP_COST) {
+      greedyRefineSOC();
+    }
+    return;
+  }
+
+  // initialize, starts are visited in order of distances from scratch,
+  // hence fields are not taken from the cache
   std::queue<int> Q;
-  for (int i = 0; i < P->getNum(); ++i) {
+  for (int i = 0; i < getNum(); ++i) {
     Q.push(i);
-    auto g = P->getGoal(i);
+    auto g = goals[i];
     OPEN_LAZY[i].push(g);
-    DIST_LAZY[i][g->id] = 0;
+    DIST_LAZY[i].set(g, 0);
   }
 
   assigned_goals.clear();
@@ -261,18 +930,18 @@ void GoalAllocator::greedySwapAssign()
   constexpr int NON_START = -2;
   constexpr int FREE_START = -1;
   std::vector<int> start_agent_pairs(P->getG()->getNodesSize(), NON_START);
-  for (int i = 0; i < P->getNum(); ++i) {
-    start_agent_pairs[P->getStart(i)->id] = FREE_START;
+  for (int i = 0; i < getNum(); ++i) {
+    start_agent_pairs[starts[i]->id] = FREE_START;
     assigned_starts.push_back(nullptr);
   }
 
-  while (!Q.empty()) {
+  while (!Q.empty() && !cancelled) {
     auto i = Q.front();
     Q.pop();
 
     while (!OPEN_LAZY[i].empty()) {
       auto n = OPEN_LAZY[i].front();
-      auto d_n = DIST_LAZY[i][n->id];
+      auto d_n = DIST_LAZY[i].get(n);
 
       // check assignment
       auto j = start_agent_pairs[n->id];
@@ -280,7 +949,7 @@ void GoalAllocator::greedySwapAssign()
         assigned_starts[i] = n;
         start_agent_pairs[n->id] = i;
         break;
-      } else if (j != NON_START && d_n < DIST_LAZY[j][n->id]) {
+      } else if (j != NON_START && d_n < DIST_LAZY[j].get(n)) {
         assigned_starts[i] = n;
         start_agent_pairs[n->id] = i;
         assigned_starts[j] = nullptr;
@@ -289,15 +958,17 @@ void GoalAllocator::greedySwapAssign()
       }
       // pop
       OPEN_LAZY[i].pop();
+      ++lazy_eval_expanded;
 
       for (auto m : n->neighbor) {
-        const int d_m = DIST_LAZY[i][m->id];
+        const int d_m = DIST_LAZY[i].get(m);
         if (d_n + 1 >= d_m) continue;
-        DIST_LAZY[i][m->id] = d_n + 1;
+        DIST_LAZY[i].set(m, d_n + 1);
         OPEN_LAZY[i].push(m);
       }
     }
   }
+  if (cancelled) return;
 
   if (assignment_mode == GREEDY_SWAP) {
     greedyRefine();
@@ -306,13 +977,76 @@ void GoalAllocator::greedySwapAssign()
   }
 }
 
+void GoalAllocator::greedySwapInitByOracle()
+{
+  // the same rule as BFS, i.e., a goal takes the nearest start that is free
+  // or held by a farther goal, where starts are ordered by (distance, index)
+  // and found by Manhattan distance, a lower bound, within doubling radii
+  using Candidate = std::pair<int, int>;  // distance, start index
+  const int N = getNum();
+  const int max_dist = P->getG()->getNodesSize();
+  LibGA::SpatialIndex starts_index(reinterpret_cast<Grid*>(P->getG()), N);
+  for (int k = 0; k < N; ++k) starts_index.insert(k, starts[k]);
+  std::vector<std::vector<Candidate>> candidates(N);  // descending
+  std::vector<int> radius(N, -1);  // starts within it are already found
+  auto nextCandidates = [&](const int i) {
+    auto g = goals[i];
+    auto& C = candidates[i];
+    while (C.empty() && radius[i] < max_dist) {
+      const int r_prev = radius[i];
+      radius[i] = std::max(ORACLE_RADIUS, radius[i] * 2);
+      starts_index.query(g, radius[i], [&](const int k) {
+        const int d = oracle->get(starts[k], g);
+        if (r_prev < d && d <= radius[i]) C.emplace_back(d, k);
+      });
+    }
+    std::sort(C.begin(), C.end(), std::greater<Candidate>());
+  };
+
+  std::queue<int> Q;
+  for (int i = 0; i < N; ++i) Q.push(i);
+  std::vector<int> start_goal(N, -1);  // start index -> goal index
+  assigned_starts.assign(N, nullptr);
+  assigned_goals.clear();
+
+  while (!Q.empty()) {
+    const int i = Q.front();
+    Q.pop();
+
+    while (true) {
+      if (candidates[i].empty()) nextCandidates(i);
+      if (candidates[i].empty()) break;  // all reachable starts are visited
+      const auto [d, k] = candidates[i].back();
+
+      // check assignment
+      const int j = start_goal[k];
+      if (j == -1 || d < oracle->get(starts[k], goals[j])) {
+        assigned_starts[i] = starts[k];
+        start_goal[k] = i;
+        if (j != -1) {
+          assigned_starts[j] = nullptr;
+          Q.push(j);
+        }
+        break;
+      }
+      candidates[i].pop_back();
+    }
+  }
+}
+
 void GoalAllocator::greedyRefine()
 {
+  if (!refine_exhaustive) {
+    greedyRefineByIndex();
+    updateAssignedGoals();
+    return;
+  }
+
   // iterative refinement
   while (true) {
     int i = 0;      // bottleneck agent
     int c_now = 0;  // bottleneck cost
-    for (int k = 0; k < P->getNum(); ++k) {
+    for (int k = 0; k < getNum(); ++k) {
       auto d = getLazyEval(assigned_starts[k], k);
       if (d > c_now) {
         i = k;
@@ -320,16 +1054,21 @@ void GoalAllocator::greedyRefine()
       }
     }
     auto s_i = assigned_starts[i];
-    auto g_i = P->getGoal(i);
+    auto g_i = goals[i];
     bool updated = false;
 
-    for (int j = 0; j < P->getNum(); ++j) {
+    for (int j = 0; j < getNum(); ++j) {
       if (j == i) continue;
       auto s_j = assigned_starts[j];
-      auto g_j = P->getGoal(j);
+      auto g_j = goals[j];
       // heuristic distance
-      if (std::max(s_i->manhattanDist(g_j), s_j->manhattanDist(g_i)) >= c_now)
+      if (std::max(getLowerBound(s_i, g_j), getLowerBound(s_j, g_i)) >=
+          c_now) {
+        if (landmarks != nullptr &&
+            std::max(s_i->manhattanDist(g_j), s_j->manhattanDist(g_i)) < c_now)
+          ++lazy_eval_avoided;
         continue;
+      }
       // real distance
       auto c_swap = std::max(getLazyEval(s_i, j), getLazyEval(s_j, i));
       if (c_swap < c_now) {
@@ -343,38 +1082,34 @@ void GoalAllocator::greedyRefine()
     if (!updated) break;
   }
 
-  // assigned_starts -> assigned goals
-  std::unordered_map<Node*, Node*> tmp;  //
-  for (int i = 0; i < P->getNum(); ++i) tmp[assigned_starts[i]] = P->getGoal(i);
-  assigned_goals.clear();
-  for (int i = 0; i < P->getNum(); ++i)
-    assigned_goals.push_back(tmp[P->getStart(i)]);
-
-  // compute quality
-  matching_cost = 0;
-  matching_makespan = 0;
-  for (int i = 0; i < P->getNum(); ++i) {
-    auto c = getLazyEval(assigned_starts[i], i);
-    matching_makespan = std::max(matching_makespan, c);
-    matching_cost += c;
-  }
+  updateAssignedGoals();
 }
 
 void GoalAllocator::greedyRefineSOC()
 {
+  if (!refine_exhaustive) {
+    greedyRefineSOCByIndex();
+    updateAssignedGoals();
+    return;
+  }
+
   // iterative refinement
   while (true) {
     bool updated = false;
-    for (int i = 0; i < P->getNum(); ++i)
-      for (int j = i + 1; j < P->getNum(); ++j) {
+    for (int i = 0; i < getNum(); ++i)
+      for (int j = i + 1; j < getNum(); ++j) {
         auto s_i = assigned_starts[i];
         auto s_j = assigned_starts[j];
-        auto g_i = P->getGoal(i);
-        auto g_j = P->getGoal(j);
+        auto g_i = goals[i];
+        auto g_j = goals[j];
         auto c_now = getLazyEval(s_i, i) + getLazyEval(s_j, j);
         // heuristic distance
-        if (s_i->manhattanDist(g_j) + s_j->manhattanDist(g_i) >= c_now)
+        if (getLowerBound(s_i, g_j) + getLowerBound(s_j, g_i) >= c_now) {
+          if (landmarks != nullptr &&
+              s_i->manhattanDist(g_j) + s_j->manhattanDist(g_i) < c_now)
+            ++lazy_eval_avoided;
           continue;
+        }
         // real distance
         auto c_swap = getLazyEval(s_i, j) + getLazyEval(s_j, i);
         if (c_swap < c_now) {
@@ -386,31 +1121,195 @@ void GoalAllocator::greedyRefineSOC()
     if (!updated) break;
   }
 
+  updateAssignedGoals();
+}
+
+void GoalAllocator::updateAssignedGoals()
+{
   // assigned_starts -> assigned goals
   std::unordered_map<Node*, Node*> tmp;
-  for (int i = 0; i < P->getNum(); ++i) tmp[assigned_starts[i]] = P->getGoal(i);
+  for (int i = 0; i < getNum(); ++i) tmp[assigned_starts[i]] = goals[i];
   assigned_goals.clear();
-  for (int i = 0; i < P->getNum(); ++i)
-    assigned_goals.push_back(tmp[P->getStart(i)]);
+  for (int i = 0; i < getNum(); ++i)
+    assigned_goals.push_back(tmp[starts[i]]);
+  updateQuality();
+}
 
-  // compute quality
+void GoalAllocator::updateQuality()
+{
   matching_cost = 0;
   matching_makespan = 0;
-  for (int i = 0; i < P->getNum(); ++i) {
+  for (int i = 0; i < getNum(); ++i) {
     auto c = getLazyEval(assigned_starts[i], i);
     matching_makespan = std::max(matching_makespan, c);
     matching_cost += c;
   }
 }
 
+void GoalAllocator::greedyRefineByIndex()
+{
+  const int N = getNum();
+  LibGA::SpatialIndex starts_index(reinterpret_cast<Grid*>(P->getG()), N);
+  std::vector<int> cost(N);  // agent -> current distance
+
+  // bottleneck agent, larger cost and then smaller index first
+  std::priority_queue<std::pair<int, int>> Q;  // cost, -index
+  for (int k = 0; k < N; ++k) {
+    starts_index.insert(k, assigned_starts[k]);
+    cost[k] = getLazyEval(assigned_starts[k], k);
+    Q.emplace(cost[k], -k);
+  }
+
+  std::vector<int> candidates;
+  while (!Q.empty()) {
+    const int c_now = Q.top().first;  // bottleneck cost
+    const int i = -Q.top().second;    // bottleneck agent
+    if (cost[i] != c_now) {           // outdated
+      Q.pop();
+      continue;
+    }
+    auto s_i = assigned_starts[i];
+    auto g_i = goals[i];
+
+    // swaps require s_j closer to g_i than c_now
+    candidates.clear();
+    if (c_now > 0) {
+      starts_index.query(g_i, c_now - 1, [&](const int j) {
+        if (j != i) candidates.push_back(j);
+      });
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    bool updated = false;
+    for (auto j : candidates) {
+      auto s_j = assigned_starts[j];
+      auto g_j = goals[j];
+      // heuristic distance
+      if (std::max(getLowerBound(s_i, g_j), getLowerBound(s_j, g_i)) >=
+          c_now) {
+        if (landmarks != nullptr &&
+            std::max(s_i->manhattanDist(g_j), s_j->manhattanDist(g_i)) < c_now)
+          ++lazy_eval_avoided;
+        continue;
+      }
+      // real distance
+      auto c_swap = std::max(getLazyEval(s_i, j), getLazyEval(s_j, i));
+      if (c_swap < c_now) {
+        assigned_starts[i] = s_j;
+        assigned_starts[j] = s_i;
+        if (assigned) std::swap(goal_agent[i], goal_agent[j]);  // reassign()
+        starts_index.move(i, s_j);
+        starts_index.move(j, s_i);
+        cost[i] = getLazyEval(s_j, i);
+        cost[j] = getLazyEval(s_i, j);
+        Q.emplace(cost[i], -i);
+        Q.emplace(cost[j], -j);
+        updated = true;
+        break;
+      }
+    }
+
+    if (!updated) break;
+  }
+}
+
+void GoalAllocator::greedyRefineSOCByIndex()
+{
+  const int N = getNum();
+  auto grid = reinterpret_cast<Grid*>(P->getG());
+  LibGA::SpatialIndex starts_index(grid, N);
+  LibGA::SpatialIndex goals_index(grid, N);
+  std::vector<int> cost(N);  // agent -> current distance
+
+  // upper bounds of costs of agents whose goals are in the cell
+  std::vector<int> cell_cost_max(goals_index.cells.size(), 0);
+  int cost_max = 0;
+  auto updateCost = [&](const int k) {
+    cost[k] = getLazyEval(assigned_starts[k], k);
+    auto& c_max = cell_cost_max[goals_index.item_cell[k]];
+    c_max = std::max(c_max, cost[k]);
+    cost_max = std::max(cost_max, c_max);
+  };
+
+  // agents whose assignments changed
+  std::queue<int> Q;
+  std::vector<bool> queued(N, true);
+  for (int k = 0; k < N; ++k) {
+    starts_index.insert(k, assigned_starts[k]);
+    goals_index.insert(k, goals[k]);
+    updateCost(k);
+    Q.push(k);
+  }
+
+  std::vector<int> candidates;
+  while (!Q.empty()) {
+    const int i = Q.front();
+    Q.pop();
+    queued[i] = false;
+    auto s_i = assigned_starts[i];
+    auto g_i = goals[i];
+
+    // an improving swap shortens at least one of two,
+    // i.e., d(s_j, g_i) < cost[i] or d(s_i, g_j) < cost[j]
+    candidates.clear();
+    if (cost[i] > 0) {
+      starts_index.query(g_i, cost[i] - 1, [&](const int j) {
+        if (g_i->manhattanDist(assigned_starts[j]) < cost[i])
+          candidates.push_back(j);
+      });
+    }
+    goals_index.forEachCell(
+        s_i, cost_max - 1, [&](const int cell, const int d) {
+          if (d >= cell_cost_max[cell]) return;
+          for (auto j : goals_index.cells[cell]) {
+            if (s_i->manhattanDist(goals[j]) < cost[j])
+              candidates.push_back(j);
+          }
+        });
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+
+    for (auto j : candidates) {
+      if (j == i) continue;
+      auto s_j = assigned_starts[j];
+      auto g_j = goals[j];
+      auto c_now = cost[i] + cost[j];
+      // heuristic distance
+      if (getLowerBound(s_i, g_j) + getLowerBound(s_j, g_i) >= c_now) {
+        if (landmarks != nullptr &&
+            s_i->manhattanDist(g_j) + s_j->manhattanDist(g_i) < c_now)
+          ++lazy_eval_avoided;
+        continue;
+      }
+      // real distance
+      auto c_swap = getLazyEval(s_i, j) + getLazyEval(s_j, i);
+      if (c_swap < c_now) {
+        assigned_starts[i] = s_j;
+        assigned_starts[j] = s_i;
+        starts_index.move(i, s_j);
+        starts_index.move(j, s_i);
+        updateCost(i);
+        updateCost(j);
+        for (auto k : {i, j}) {
+          if (queued[k]) continue;
+          queued[k] = true;
+          Q.push(k);
+        }
+        break;
+      }
+    }
+  }
+}
+
 void GoalAllocator::greedySwapAssignWoLazy()
 {
-  assigned_starts = Nodes(P->getNum(), nullptr);
+  assigned_starts = Nodes(getNum(), nullptr);
   setAllStartGoalDistances();
   std::queue<int> U;  // undecided
-  std::vector<std::queue<Node*>> D(P->getNum(),
+  std::vector<std::queue<Node*>> D(getNum(),
                                    std::queue<Node*>());  // distance
-  for (int i = 0; i < P->getNum(); ++i) {
+  for (int i = 0; i < getNum(); ++i) {
     U.push(i);
     auto compare = [&](Node* a, Node* b) {
       auto d_a = getLazyEval(a, i);
@@ -418,7 +1317,7 @@ void GoalAllocator::greedySwapAssignWoLazy()
       if (d_a != d_b) return d_a < d_b;
       return a->id < b->id;
     };
-    auto tmp = P->getConfigStart();
+    auto tmp = starts;
     std::sort(tmp.begin(), tmp.end(), compare);
     for (auto s : tmp) D[i].push(s);
   }
@@ -450,45 +1349,258 @@ void GoalAllocator::greedySwapAssignWoLazy()
   greedyRefine();
 }
 
+void GoalAllocator::hierarchicalAssign()
+{
+  const int N = getNum();
+  auto grid = reinterpret_cast<Grid*>(P->getG());
+  const int regions_x = (grid->getWidth() + REGION_WIDTH - 1) / REGION_WIDTH;
+  const int regions_y = (grid->getHeight() + REGION_WIDTH - 1) / REGION_WIDTH;
+  const int R = regions_x * regions_y;
+  auto getRegion = [&](Node* const v) {
+    return (v->pos.y / REGION_WIDTH) * regions_x + v->pos.x / REGION_WIDTH;
+  };
+
+  // starts and goals per region
+  std::vector<std::vector<int>> region_starts(R);
+  std::vector<std::vector<int>> region_goals(R);
+  for (int i = 0; i < N; ++i) {
+    region_starts[getRegion(starts[i])].push_back(i);
+    region_goals[getRegion(goals[i])].push_back(i);
+  }
+
+  // non-empty regions
+  std::vector<int> sources, sinks;
+  std::vector<int> supply, demand;
+  for (int r = 0; r < R; ++r) {
+    if (!region_starts[r].empty()) {
+      sources.push_back(r);
+      supply.push_back(region_starts[r].size());
+    }
+    if (!region_goals[r].empty()) {
+      sinks.push_back(r);
+      demand.push_back(region_goals[r].size());
+    }
+  }
+  const int A = sources.size();
+  const int B = sinks.size();
+
+  // BFS from all goals of each goal region,
+  // dist_region[b * N + i] = distance from start i to the nearest goal of b
+  const int inf = P->getG()->getNodesSize();
+  std::vector<int> dist_region(B * N, inf);
+  pool->parallelFor(B, [&](const int b, const int) {
+    std::vector<int> dist(inf, inf);
+    std::queue<Node*> open;
+    for (auto j : region_goals[sinks[b]]) {
+      dist[goals[j]->id] = 0;
+      open.push(goals[j]);
+    }
+    while (!open.empty()) {
+      auto v = open.front();
+      open.pop();
+      for (auto u : v->neighbor) {
+        if (dist[u->id] != inf) continue;
+        dist[u->id] = dist[v->id] + 1;
+        open.push(u);
+      }
+    }
+    for (int i = 0; i < N; ++i) dist_region[b * N + i] = dist[starts[i]->id];
+  });
+
+  // transportation between regions by the mean distance
+  std::vector<int> cost(A * B);
+  for (int a = 0; a < A; ++a) {
+    auto& indexes = region_starts[sources[a]];
+    for (int b = 0; b < B; ++b) {
+      long long sum = 0;
+      for (auto i : indexes) sum += dist_region[b * N + i];
+      cost[a * B + b] = sum / indexes.size();
+    }
+  }
+  if (cancelled) return;
+  auto flow = LibGA::Transport::solve(supply, demand, cost);
+
+  // send starts of each region to goal regions by transportation again
+  std::vector<Config> sub_starts(B), sub_goals(B);
+  std::vector<std::vector<int>> sub_start_indexes(B);
+  for (int a = 0; a < A; ++a) {
+    auto& indexes = region_starts[sources[a]];
+    std::vector<int> targets;  // goal regions
+    std::vector<int> amount;
+    for (int b = 0; b < B; ++b) {
+      if (flow[a * B + b] == 0) continue;
+      targets.push_back(b);
+      amount.push_back(flow[a * B + b]);
+    }
+    const int K = targets.size();
+    std::vector<int> cost_start(indexes.size() * K);
+    for (int k = 0; k < (int)indexes.size(); ++k) {
+      for (int l = 0; l < K; ++l)
+        cost_start[k * K + l] = dist_region[targets[l] * N + indexes[k]];
+    }
+    auto flow_start = LibGA::Transport::solve(
+        std::vector<int>(indexes.size(), 1), amount, cost_start);
+    for (int k = 0; k < (int)indexes.size(); ++k) {
+      for (int l = 0; l < K; ++l) {
+        if (flow_start[k * K + l] == 0) continue;
+        sub_starts[targets[l]].push_back(starts[indexes[k]]);
+        sub_start_indexes[targets[l]].push_back(indexes[k]);
+      }
+    }
+  }
+  for (int b = 0; b < B; ++b) {
+    for (auto j : region_goals[sinks[b]]) sub_goals[b].push_back(goals[j]);
+  }
+
+  // independent assignment per goal region
+  assigned_goals.assign(N, nullptr);
+  pool->parallelFor(B, [&](const int b, const int) {
+    if (cancelled) return;
+    Problem Q(P, sub_starts[b], sub_goals[b], P->getMaxCompTime(),
+              P->getMaxTimestep());
+    GoalAllocator allocator(&Q, BOTTLENECK_LINEAR);
+    allocator.setLevelBatch(level_batch);
+    allocator.setOracle(oracle);
+    allocator.setLandmarks(landmarks);
+    allocator.assign();
+    auto sub_assigned_goals = allocator.getAssignedGoals();
+    for (int k = 0; k < (int)sub_start_indexes[b].size(); ++k)
+      assigned_goals[sub_start_indexes[b][k]] = sub_assigned_goals[k];
+  });
+  if (cancelled) return;
+
+  // regions ignore walls inside, fix bottlenecks across regions by swaps
+  std::unordered_map<Node*, int> goal_indexes;
+  for (int j = 0; j < N; ++j) goal_indexes[goals[j]] = j;
+  assigned_starts.assign(N, nullptr);
+  for (int i = 0; i < N; ++i)
+    assigned_starts[goal_indexes[assigned_goals[i]]] = starts[i];
+  auto assigned_starts_regions = assigned_starts;
+  greedyRefineByIndex();
+
+  // then the sum of costs around swapped pairs
+  goal_changed.assign(N, false);
+  for (int j = 0; j < N; ++j)
+    goal_changed[j] = (assigned_starts[j] != assigned_starts_regions[j]);
+  std::unordered_map<Node*, int> start_indexes;
+  for (int i = 0; i < N; ++i) start_indexes[starts[i]] = i;
+  goal_agent.resize(N);
+  for (int j = 0; j < N; ++j) goal_agent[j] = start_indexes[assigned_starts[j]];
+  repairByCycleCanceling(REPAIR_HOPS);
+  updateAssignedGoals();
+}
+
 void GoalAllocator::setAllStartGoalDistances()
 {
+  // getLazyEval answers from the oracle
+  if (oracle != nullptr) return;
+
+  if (getNum() >= MULTI_SOURCE_BFS_MIN_AGENTS) {
+    // advance BFS of a batch of goals together,
+    // nearby goals share BFS levels, so goals are batched in z-order
+    auto z_order = [](Node* v) {
+      uint64_t key = 0;
+      for (int b = 0; b < 32; ++b) {
+        key |= (uint64_t)((v->pos.x >> b) & 1) << (2 * b);
+        key |= (uint64_t)((v->pos.y >> b) & 1) << (2 * b + 1);
+      }
+      return key;
+    };
+    // fields taken over from the cache are resumed by lazy evaluation
+    std::vector<int> goal_indexes;
+    for (int i = 0; i < getNum(); ++i) {
+      fetchField(i);
+      if (DIST_LAZY[i].get(goals[i]) != 0) goal_indexes.push_back(i);
+    }
+    std::sort(goal_indexes.begin(), goal_indexes.end(), [&](int i, int j) {
+      return z_order(goals[i]) < z_order(goals[j]);
+    });
+
+    constexpr int B = LibGA::MultiSourceBFS::BATCH_SIZE;
+    const int M = goal_indexes.size();
+    const int batch_num = (M + B - 1) / B;
+    pool->parallelFor(batch_num, [&](const int k, const int) {
+      if (cancelled) return;
+      Nodes batch;
+      std::vector<LibGA::DistanceField*> fields;
+      std::vector<std::queue<Node*>*> opens;
+      for (int j = k * B; j < std::min((k + 1) * B, M); ++j) {
+        const int i = goal_indexes[j];
+        batch.push_back(goals[i]);
+        fields.push_back(&DIST_LAZY[i]);
+        opens.push_back(&OPEN_LAZY[i]);
+      }
+      LibGA::MultiSourceBFS::run(P->getG(), batch, starts, fields, opens);
+    });
+    return;
+  }
+
   // for constant time checking
   std::vector<bool> start_indexes(P->getG()->getNodesSize(), false);
-  for (auto s : P->getConfigStart()) start_indexes[s->id] = true;
-
-  for (int i = 0; i < P->getNum(); ++i) {
-    auto g = P->getGoal(i);
-    OPEN_LAZY[i].push(g);
-    DIST_LAZY[i][g->id] = 0;
+  for (auto s : starts) start_indexes[s->id] = true;
+
+  // each BFS touches only its own goal, the result is the same as serial
+  pool->parallelFor(getNum(), [&](const int i, const int) {
+    if (cancelled) return;
+    auto g = goals[i];
+    auto& dist = DIST_LAZY[i];
+    auto& open = OPEN_LAZY[i];
+    fetchField(i);
+    if (dist.get(g) == 0) return;  // taken over from the cache
+    open.push(g);
+    dist.set(g, 0);
 
     int start_cnt = 0;
-    while (!OPEN_LAZY[i].empty()) {
-      auto n = OPEN_LAZY[i].front();
-      const int d_n = DIST_LAZY[i][n->id];
+    while (!open.empty()) {
+      auto n = open.front();
+      const int d_n = dist.get(n);
 
       // check goal condition
       if (start_indexes[n->id]) {
         ++start_cnt;
         // all distances are computed
-        if (start_cnt == P->getNum()) break;
+        if (start_cnt == getNum()) break;
       }
 
       // pop
-      OPEN_LAZY[i].pop();
+      open.pop();
 
       // expand neighbors
       for (auto m : n->neighbor) {
-        const int d_m = DIST_LAZY[i][m->id];
+        const int d_m = dist.get(m);
         if (d_n + 1 >= d_m) continue;
-        DIST_LAZY[i][m->id] = d_n + 1;
-        OPEN_LAZY[i].push(m);
+        dist.set(m, d_n + 1);
+        open.push(m);
       }
     }
-  }
+  });
 }
 
 Nodes GoalAllocator::getAssignedGoals() const { return assigned_goals; }
 
+Config GoalAllocator::getStarts() const { return starts; }
+
+Config GoalAllocator::getGoals() const { return goals; }
+
+int GoalAllocator::getAgentGoal(const int i) const
+{
+  if (!assigned || i < 0 || i >= getNum()) halt("invalid operation");
+  return agent_goal[i];
+}
+
+int GoalAllocator::getGoalAgent(const int j) const
+{
+  if (!assigned || j < 0 || j >= getNum()) halt("invalid operation");
+  return goal_agent[j];
+}
+
 int GoalAllocator::getCost() const { return matching_cost; }
 
 int GoalAllocator::getMakespan() const { return matching_makespan; }
+
+int GoalAllocator::getLazyEvalAvoided() const { return lazy_eval_avoided; }
+
+uint64_t GoalAllocator::getLazyEvalExpanded() const
+{
+  return lazy_eval_expanded;
+}
@@ -1,7 +1,7 @@
 #include "../include/lib_ga.hpp"
 
 #include <climits>
-#include <cstring>
+#include <limits>
 #include <queue>
 
 LibGA::FieldEdge::FieldEdge(int sindex, int gindex, Node* _s, Node* _g, int _d)
@@ -35,15 +35,733 @@ void LibGA::FieldEdge::setRealDist(int _d)
   }
 }
 
+uint16_t* const LibGA::DistanceField::EMPTY_TILE_16 = [] {
+  static uint16_t tile[TILE_SIZE];
+  std::fill(tile, tile + TILE_SIZE, UNKNOWN_16);
+  return tile;
+}();
+
+uint32_t* const LibGA::DistanceField::EMPTY_TILE_32 = [] {
+  static uint32_t tile[TILE_SIZE];
+  std::fill(tile, tile + TILE_SIZE, UNKNOWN_32);
+  return tile;
+}();
+
+LibGA::DistanceField::DistanceField(Grid* grid, const int _inf,
+                                    const bool _wide)
+    : inf(_inf),
+      wide(_wide),
+      tiles_x((grid->getWidth() + TILE_WIDTH - 1) >> TILE_BITS)
+{
+  const int tiles_y = (grid->getHeight() + TILE_WIDTH - 1) >> TILE_BITS;
+  if (wide) {
+    tiles_32.assign(tiles_x * tiles_y, EMPTY_TILE_32);
+  } else {
+    tiles_16.assign(tiles_x * tiles_y, EMPTY_TILE_16);
+  }
+}
+
+bool LibGA::DistanceField::requireWide(Graph* G)
+{
+  // distances are less than the number of nodes, UNKNOWN is reserved
+  return G->getV().size() >= UNKNOWN_16;
+}
+
+void LibGA::DistanceField::allocateTile(const int t)
+{
+  if (wide) {
+    allocated_32.push_back(std::make_unique<uint32_t[]>(TILE_SIZE));
+    tiles_32[t] = allocated_32.back().get();
+    std::fill(tiles_32[t], tiles_32[t] + TILE_SIZE, UNKNOWN_32);
+  } else {
+    allocated_16.push_back(std::make_unique<uint16_t[]>(TILE_SIZE));
+    tiles_16[t] = allocated_16.back().get();
+    std::fill(tiles_16[t], tiles_16[t] + TILE_SIZE, UNKNOWN_16);
+  }
+}
+
+size_t LibGA::DistanceField::getMemoryUsage() const
+{
+  if (wide) return allocated_32.size() * TILE_SIZE * sizeof(uint32_t);
+  return allocated_16.size() * TILE_SIZE * sizeof(uint16_t);
+}
+
+void LibGA::DistanceField::clear()
+{
+  if (wide) {
+    std::fill(tiles_32.begin(), tiles_32.end(), EMPTY_TILE_32);
+    std::vector<std::unique_ptr<uint32_t[]>>().swap(allocated_32);
+  } else {
+    std::fill(tiles_16.begin(), tiles_16.end(), EMPTY_TILE_16);
+    std::vector<std::unique_ptr<uint16_t[]>>().swap(allocated_16);
+  }
+}
+
+void LibGA::DistanceField::swap(DistanceField& other)
+{
+  tiles_16.swap(other.tiles_16);
+  tiles_32.swap(other.tiles_32);
+  allocated_16.swap(other.allocated_16);
+  allocated_32.swap(other.allocated_32);
+}
+
+void LibGA::DistanceField::repair(Grid* grid, Node* const g,
+                                  std::queue<Node*>& open,
+                                  const Nodes& blocked,
+                                  const Nodes& unblocked)
+{
+  // BFS has not started
+  if (get(g) != 0) return;
+
+  // restarted by the next evaluation, all nodes are unreachable
+  if (inArray(g, blocked)) {
+    clear();
+    std::queue<Node*>().swap(open);
+    return;
+  }
+
+  // nodes of distance less than L have been expanded,
+  // those of L and L + 1 are in the open list
+  const int L = open.empty() ? inf : get(open.front());
+
+  // nodes next to v on the grid, including blocked ones
+  Nodes around;
+  auto setAround = [&](Node* const v) {
+    static constexpr int dx[] = {-1, 1, 0, 0};
+    static constexpr int dy[] = {0, 0, -1, 1};
+    around.clear();
+    for (int k = 0; k < 4; ++k) {
+      const int x = v->pos.x + dx[k];
+      const int y = v->pos.y + dy[k];
+      if (grid->existNode(x, y)) around.push_back(grid->getNode(x, y));
+    }
+  };
+
+  // forget distances depending on blocked nodes, in increasing order,
+  // a node keeps its distance when a neighbor is one step closer
+  RadixHeap heap;
+  Nodes invalid;
+  auto invalidate = [&](Node* const v, const int d_v) {
+    reset(v);
+    invalid.push_back(v);
+    setAround(v);
+    for (auto u : around) {
+      if (get(u) == d_v + 1) heap.push(d_v + 1, u->id);
+    }
+  };
+  for (auto v : blocked) {
+    const int d_v = get(v);
+    if (d_v != inf) invalidate(v, d_v);
+  }
+  while (!heap.empty()) {
+    auto u = grid->getNode(heap.pop());
+    const int d_u = heap.last;
+    if (get(u) != d_u) continue;  // already invalidated
+    bool supported = false;
+    for (auto w : u->neighbor) {
+      if (get(w) == d_u - 1) {
+        supported = true;
+        break;
+      }
+    }
+    if (!supported) invalidate(u, d_u);
+  }
+
+  // Dijkstra from neighbors of invalidated and unblocked nodes, nodes of
+  // L and L + 1 are left in the open list, and the others are left unknown
+  heap.clear();
+  auto seed = [&](Node* const u) {
+    int d_u = inf;
+    for (auto w : u->neighbor) d_u = std::min(d_u, get(w) + 1);
+    if (d_u < inf) heap.push(d_u, u->id);
+  };
+  for (auto u : invalid) seed(u);
+  for (auto v : unblocked) {
+    seed(v);
+    const int d_v = get(v);
+    if (d_v == inf) continue;
+    for (auto u : v->neighbor) {
+      if (d_v + 1 < get(u)) heap.push(d_v + 1, u->id);
+    }
+  }
+  Nodes frontier;
+  while (!heap.empty()) {
+    auto u = grid->getNode(heap.pop());
+    const int d_u = heap.last;
+    if (d_u > L + 1 || get(u) <= d_u) continue;
+    set(u, d_u);
+    if (d_u >= L) {
+      frontier.push_back(u);
+      continue;
+    }
+    for (auto w : u->neighbor) {
+      if (d_u + 1 < get(w)) heap.push(d_u + 1, w->id);
+    }
+  }
+
+  // rebuild the open list in BFS order
+  while (!open.empty()) {
+    auto v = open.front();
+    open.pop();
+    if (get(v) >= L && get(v) != inf) frontier.push_back(v);
+  }
+  std::sort(frontier.begin(), frontier.end(), [&](Node* v, Node* u) {
+    if (get(v) != get(u)) return get(v) < get(u);
+    return v->id < u->id;
+  });
+  frontier.erase(std::unique(frontier.begin(), frontier.end()), frontier.end());
+  for (auto v : frontier) open.push(v);
+}
+
+LibGA::ResumableAstar::ResumableAstar(Grid* _grid, Node* const _g,
+                                      const int _inf, const bool _wide)
+    : grid(_grid),
+      g(_g),
+      inf(_inf),
+      target(_g),
+      field(_grid, std::numeric_limits<int>::max(), _wide),
+      f_min(0),
+      f_cur(0)
+{
+  field.set(g, 0);
+  push(g);
+}
+
+bool LibGA::ResumableAstar::requireWide(Graph* G)
+{
+  // doubled distances are less than twice the number of nodes
+  return G->getV().size() * 2 >= DistanceField::UNKNOWN_16;
+}
+
+void LibGA::ResumableAstar::push(Node* const v)
+{
+  const int k = getF(v) - f_min;
+  if (k >= (int)open.size()) open.resize(k + 1);
+  open[k].push_back(v->id);
+}
+
+int LibGA::ResumableAstar::get(Node* const s, uint64_t& expanded)
+{
+  const int x_s = field.get(s);
+  if (x_s != field.inf && (x_s & 1)) return x_s >> 1;  // closed
+
+  // reorder the open list for the new node, skipping outdated entries
+  if (s != target) {
+    std::vector<int> nodes;
+    for (int k = f_cur; k < (int)open.size(); ++k) {
+      for (auto id : open[k]) {
+        auto v = grid->getNode(id);
+        if ((field.get(v) & 1) || getF(v) != f_min + k) continue;
+        nodes.push_back(id);
+      }
+      open[k].clear();
+    }
+    target = s;
+    f_min = std::numeric_limits<int>::max();
+    for (auto id : nodes) f_min = std::min(f_min, getF(grid->getNode(id)));
+    f_cur = 0;
+    for (auto id : nodes) push(grid->getNode(id));
+  }
+
+  // A*, ties are broken by the last pushed node, i.e., often deeper ones
+  while (true) {
+    while (f_cur < (int)open.size() && open[f_cur].empty()) ++f_cur;
+    if (f_cur == (int)open.size()) break;
+    auto v = grid->getNode(open[f_cur].back());
+    open[f_cur].pop_back();
+    const int x_v = field.get(v);
+    if ((x_v & 1) || getF(v) != f_min + f_cur) continue;  // outdated
+    const int d = x_v >> 1;
+    field.set(v, x_v + 1);
+    ++expanded;
+    for (auto u : v->neighbor) {
+      if (field.get(u) <= 2 * (d + 1) + 1) continue;
+      field.set(u, 2 * (d + 1));
+      push(u);
+    }
+    if (v == s) return d;
+  }
+  return inf;
+}
+
+LibGA::NextHopField::NextHopField(Graph* G, const DistanceField& dist)
+    : bits((G->getNodesSize() + 3) / 4, 0),
+      unknown(G->getNodesSize(), false)
+{
+  for (auto v : G->getV()) {
+    if (v->neighbor.empty()) continue;  // isolated, e.g., blocked
+    const int d_v = dist.get(v);
+    if (d_v == dist.inf) {
+      unknown[v->id] = true;
+      continue;
+    }
+    if (d_v == 0) continue;  // goal
+    int k = 0;
+    while (dist.get(v->neighbor[k]) >= d_v) ++k;
+    if (k >= MAX_DEGREE) {
+      unknown[v->id] = true;
+      continue;
+    }
+    bits[v->id >> 2] |= k << ((v->id & 3) << 1);
+  }
+}
+
+LibGA::FieldCache::Entry::Entry(Graph* G, const uint64_t _map_hash,
+                                const int _goal_id)
+    : map_hash(_map_hash),
+      goal_id(_goal_id),
+      field(reinterpret_cast<Grid*>(G), G->getNodesSize(),
+            DistanceField::requireWide(G)),
+      memory_usage(0)
+{
+}
+
+LibGA::FieldCache::FieldCache(const size_t _capacity)
+    : capacity(_capacity),
+      memory_usage(0),
+      hit_cnt(0),
+      miss_cnt(0),
+      eviction_cnt(0)
+{
+}
+
+std::shared_ptr<LibGA::FieldCache> LibGA::FieldCache::getShared()
+{
+  static auto shared = std::make_shared<FieldCache>();
+  return shared;
+}
+
+void LibGA::FieldCache::setCapacity(const size_t _capacity)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  capacity = _capacity;
+  evict();
+}
+
+void LibGA::FieldCache::evict()
+{
+  while (memory_usage > capacity && !entries.empty()) {
+    auto& entry = entries.back();
+    memory_usage -= entry->memory_usage;
+    table.erase({entry->map_hash, entry->goal_id});
+    entries.pop_back();
+    ++eviction_cnt;
+  }
+}
+
+bool LibGA::FieldCache::checkOut(Graph* G, const uint64_t map_hash,
+                                 Node* const g, DistanceField& field,
+                                 std::queue<Node*>& open)
+{
+  std::unique_ptr<Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto itr = table.find({map_hash, g->id});
+    if (itr == table.end()) {
+      ++miss_cnt;
+      return false;
+    }
+    ++hit_cnt;
+    entry = std::move(*(itr->second));
+    entries.erase(itr->second);
+    table.erase(itr);
+    memory_usage -= entry->memory_usage;
+  }
+
+  field.swap(entry->field);
+  std::queue<Node*>().swap(open);
+  for (auto id : entry->open) open.push(G->getNode(id));
+  return true;
+}
+
+void LibGA::FieldCache::checkIn(Graph* G, const uint64_t map_hash,
+                                Node* const g, DistanceField& field,
+                                std::queue<Node*>& open)
+{
+  auto entry = std::make_unique<Entry>(G, map_hash, g->id);
+  entry->field.swap(field);
+  entry->open.reserve(open.size());
+  while (!open.empty()) {
+    entry->open.push_back(open.front()->id);
+    open.pop();
+  }
+  entry->memory_usage =
+      entry->field.getMemoryUsage() + entry->open.size() * sizeof(int);
+
+  std::lock_guard<std::mutex> lock(mtx);
+  auto itr = table.find({map_hash, g->id});
+  if (itr != table.end()) {
+    memory_usage -= (*(itr->second))->memory_usage;
+    entries.erase(itr->second);
+    table.erase(itr);
+  }
+  memory_usage += entry->memory_usage;
+  entries.push_front(std::move(entry));
+  table[{map_hash, g->id}] = entries.begin();
+  evict();
+}
+
+size_t LibGA::FieldCache::size() const
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return entries.size();
+}
+
+size_t LibGA::FieldCache::getMemoryUsage() const
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return memory_usage;
+}
+
+uint64_t LibGA::FieldCache::getHits() const
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return hit_cnt;
+}
+
+uint64_t LibGA::FieldCache::getMisses() const
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return miss_cnt;
+}
+
+uint64_t LibGA::FieldCache::getEvictions() const
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return eviction_cnt;
+}
+
+void LibGA::MultiSourceBFS::run(Graph* G, const Nodes& goals,
+                                const Nodes& targets,
+                                const std::vector<DistanceField*>& fields,
+                                const std::vector<std::queue<Node*>*>& opens)
+{
+  const int K = goals.size();
+  if (K > BATCH_SIZE) halt("lib_ga, too many goals for one batch");
+
+  auto setBit = [](Bits& b, const int i) { b[i / 64] |= 1ULL << (i % 64); };
+  auto any = [](const Bits& b) {
+    uint64_t w = 0;
+    for (int k = 0; k < WORDS; ++k) w |= b[k];
+    return w != 0;
+  };
+  // call f(goal index) for each set bit
+  auto forEachBit = [](const Bits& b, auto f) {
+    for (int k = 0; k < WORDS; ++k) {
+      for (uint64_t w = b[k]; w != 0; w &= w - 1)
+        f(k * 64 + __builtin_ctzll(w));
+    }
+  };
+
+  std::vector<Bits> visited(G->getNodesSize(), Bits());
+  std::vector<Bits> reached(G->getNodesSize(), Bits());  // at next level
+  std::vector<bool> is_target(G->getNodesSize(), false);
+  for (auto v : targets) is_target[v->id] = true;
+
+  Bits active = Bits();  // goals not yet finished
+  std::vector<int> rest(K, targets.size());
+
+  // current level, cells and their newly reached bits
+  Nodes frontier;
+  std::vector<Bits> frontier_bits;
+  Bits finished = Bits();  // goals finished at the current level
+
+  auto update = [&](Node* v, const Bits& b, const int d) {
+    forEachBit(b, [&](const int i) {
+      fields[i]->set(v, d);
+      if (is_target[v->id] && --rest[i] == 0) setBit(finished, i);
+    });
+  };
+
+  // the open list of a finished goal consists of the cells of the last level
+  auto finish = [&]() {
+    if (!any(finished)) return;
+    for (int j = 0; j < (int)frontier.size(); ++j) {
+      Bits b;
+      for (int k = 0; k < WORDS; ++k) b[k] = frontier_bits[j][k] & finished[k];
+      forEachBit(b, [&](const int i) { opens[i]->push(frontier[j]); });
+    }
+    for (int k = 0; k < WORDS; ++k) active[k] &= ~finished[k];
+    finished = Bits();
+  };
+
+  // initialize
+  for (int i = 0; i < K; ++i) {
+    auto g = goals[i];
+    if (!any(visited[g->id])) {
+      frontier.push_back(g);
+      frontier_bits.push_back(Bits());
+    }
+    setBit(active, i);
+    setBit(visited[g->id], i);
+  }
+  for (int j = 0; j < (int)frontier.size(); ++j) {
+    frontier_bits[j] = visited[frontier[j]->id];
+    update(frontier[j], frontier_bits[j], 0);
+  }
+  finish();
+
+  // BFS, level by level
+  Nodes next;
+  std::vector<Bits> next_bits;
+  for (int d = 1; !frontier.empty() && any(active); ++d) {
+    // expand
+    next.clear();
+    for (int j = 0; j < (int)frontier.size(); ++j) {
+      Bits b;
+      for (int k = 0; k < WORDS; ++k) b[k] = frontier_bits[j][k] & active[k];
+      if (!any(b)) continue;
+      for (auto m : frontier[j]->neighbor) {
+        auto& r = reached[m->id];
+        auto& c = visited[m->id];
+        Bits nb;
+        for (int k = 0; k < WORDS; ++k) nb[k] = b[k] & ~c[k];
+        if (!any(nb)) continue;
+        if (!any(r)) next.push_back(m);
+        for (int k = 0; k < WORDS; ++k) r[k] |= nb[k];
+      }
+    }
+
+    // register new level
+    next_bits.resize(next.size());
+    for (int j = 0; j < (int)next.size(); ++j) {
+      auto v = next[j];
+      next_bits[j] = reached[v->id];
+      reached[v->id] = Bits();
+      for (int k = 0; k < WORDS; ++k) visited[v->id][k] |= next_bits[j][k];
+      update(v, next_bits[j], d);
+    }
+
+    std::swap(frontier, next);
+    std::swap(frontier_bits, next_bits);
+    finish();
+  }
+}
+
+LibGA::Landmarks::Landmarks(Graph* _G, const int _K)
+    : G(_G), inf(G->getNodesSize()), K(_K), dist(G->getNodesSize() * K, inf)
+{
+  Nodes V = G->getV();
+  if (V.empty() || K <= 0) return;
+
+  // BFS from a landmark, return the last expanded node
+  auto bfs = [&](Node* l, const int k) {
+    std::queue<Node*> OPEN;
+    dist[l->id * K + k] = 0;
+    OPEN.push(l);
+    Node* n = l;
+    while (!OPEN.empty()) {
+      n = OPEN.front();
+      OPEN.pop();
+      const int d_n = dist[n->id * K + k];
+      for (auto m : n->neighbor) {
+        if (dist[m->id * K + k] != inf) continue;
+        dist[m->id * K + k] = d_n + 1;
+        OPEN.push(m);
+      }
+    }
+    return n;
+  };
+
+  // farthest point selection, starting from a peripheral node
+  Node* l = bfs(V[0], 0);
+  for (auto v : V) dist[v->id * K] = inf;
+  std::vector<int> nearest(G->getNodesSize(), inf);  // to any landmark
+  for (int k = 0; k < K; ++k) {
+    landmarks.push_back(l);
+    bfs(l, k);
+    for (auto v : V) {
+      nearest[v->id] = std::min(nearest[v->id], dist[v->id * K + k]);
+    }
+    // other components are preferred since their nearest distance is inf
+    l = V[0];
+    for (auto v : V) {
+      if (nearest[v->id] > nearest[l->id]) l = v;
+    }
+    if (nearest[l->id] == 0) break;  // all nodes are landmarks
+  }
+}
+
+LibGA::SpatialIndex::SpatialIndex(Grid* grid, const int num_items)
+    : cells_x((grid->getWidth() + CELL_WIDTH - 1) >> CELL_BITS),
+      cells_y((grid->getHeight() + CELL_WIDTH - 1) >> CELL_BITS),
+      cells(cells_x * cells_y),
+      item_cell(num_items, -1),
+      item_pos(num_items, -1)
+{
+}
+
+void LibGA::SpatialIndex::insert(const int item, Node* const v)
+{
+  auto& cell = cells[getCell(v)];
+  item_cell[item] = getCell(v);
+  item_pos[item] = cell.size();
+  cell.push_back(item);
+}
+
+void LibGA::SpatialIndex::erase(const int item)
+{
+  // swap with the last one
+  auto& cell = cells[item_cell[item]];
+  const int last = cell.back();
+  cell[item_pos[item]] = last;
+  item_pos[last] = item_pos[item];
+  cell.pop_back();
+  item_cell[item] = -1;
+  item_pos[item] = -1;
+}
+
+void LibGA::SpatialIndex::move(const int item, Node* const v)
+{
+  if (item_cell[item] == getCell(v)) return;
+  erase(item);
+  insert(item, v);
+}
+
+void LibGA::RadixHeap::push(const uint32_t key, const int value)
+{
+  if (key < last) halt("radix heap, non-monotone key");
+  buckets[getBucket(key)].emplace_back(key, value);
+  ++size;
+}
+
+int LibGA::RadixHeap::pop()
+{
+  if (buckets[0].empty()) {
+    // redistribute the first non-empty bucket by its minimum key
+    int i = 1;
+    while (buckets[i].empty()) ++i;
+    last = UINT32_MAX;
+    for (auto& item : buckets[i]) last = std::min(last, item.first);
+    for (auto& item : buckets[i]) {
+      buckets[getBucket(item.first)].push_back(item);
+    }
+    buckets[i].clear();
+  }
+  const int value = buckets[0].back().second;
+  buckets[0].pop_back();
+  --size;
+  return value;
+}
+
+void LibGA::RadixHeap::clear()
+{
+  for (auto& bucket : buckets) bucket.clear();
+  last = 0;
+  size = 0;
+}
+
+std::vector<int> LibGA::Transport::solve(const std::vector<int>& supply,
+                                         const std::vector<int>& demand,
+                                         const std::vector<int>& cost)
+{
+  const int A = supply.size();
+  const int B = demand.size();
+  const int V = A + B;  // sources [0, A), sinks [A, A + B)
+  constexpr int NIL = -1;
+  constexpr long long INF = std::numeric_limits<long long>::max() / 4;
+
+  std::vector<int> flow(A * B, 0);
+  std::vector<int> supply_rest(supply);
+  std::vector<int> demand_rest(demand);
+  std::vector<long long> potential(V, 0);  // costs are non-negative first
+  std::vector<long long> dist(V);
+  std::vector<int> parent(V);
+  std::vector<bool> closed(V);
+
+  while (true) {
+    // Dijkstra from all sources with the rest, reduced costs are
+    // non-negative, residual arcs are a -> b and b -> a with flow
+    std::fill(dist.begin(), dist.end(), INF);
+    std::fill(parent.begin(), parent.end(), NIL);
+    std::fill(closed.begin(), closed.end(), false);
+    for (int a = 0; a < A; ++a) {
+      if (supply_rest[a] > 0) dist[a] = 0;
+    }
+    int sink = NIL;
+    while (true) {
+      int v = NIL;
+      for (int u = 0; u < V; ++u) {
+        if (!closed[u] && dist[u] < INF && (v == NIL || dist[u] < dist[v]))
+          v = u;
+      }
+      if (v == NIL) break;
+      closed[v] = true;
+      if (v >= A && demand_rest[v - A] > 0) {
+        sink = v;
+        break;
+      }
+      if (v < A) {
+        for (int b = 0; b < B; ++b) {
+          const int u = A + b;
+          const long long d =
+              dist[v] + cost[v * B + b] + potential[v] - potential[u];
+          if (d < dist[u]) {
+            dist[u] = d;
+            parent[u] = v;
+          }
+        }
+      } else {
+        const int b = v - A;
+        for (int a = 0; a < A; ++a) {
+          if (flow[a * B + b] == 0) continue;
+          const long long d =
+              dist[v] - cost[a * B + b] + potential[v] - potential[a];
+          if (d < dist[a]) {
+            dist[a] = d;
+            parent[a] = v;
+          }
+        }
+      }
+    }
+    if (sink == NIL) break;  // all transported
+
+    // update potentials, unreached nodes are as far as the sink
+    for (int v = 0; v < V; ++v) potential[v] += std::min(dist[v], dist[sink]);
+
+    // augment
+    int amount = demand_rest[sink - A];
+    int v = sink;
+    while (parent[v] != NIL) {
+      const int u = parent[v];
+      if (v < A) amount = std::min(amount, flow[v * B + (u - A)]);
+      v = u;
+    }
+    amount = std::min(amount, supply_rest[v]);
+    supply_rest[v] -= amount;
+    demand_rest[sink - A] -= amount;
+    for (v = sink; parent[v] != NIL; v = parent[v]) {
+      const int u = parent[v];
+      if (v >= A) {
+        flow[u * B + (v - A)] += amount;
+      } else {
+        flow[v * B + (u - A)] -= amount;
+      }
+    }
+  }
+
+  return flow;
+}
+
 LibGA::Matching::Matching(Problem* P)
-    : starts(P->getConfigStart()),
-      goals(P->getConfigGoal()),
-      N(P->getNum()),
-      adj(N * 2, std::vector<int>()),
+    : Matching(P->getConfigStart(), P->getConfigGoal())
+{
+}
+
+LibGA::Matching::Matching(const Nodes& _starts, const Nodes& _goals)
+    : starts(_starts),
+      goals(_goals),
+      N(starts.size()),
       mate(N * 2, NIL),
-      cost(N, std::vector<int>(N, NIL)),
       matched_num(0),
-      assigned_goals(N, nullptr)
+      assigned_goals(N, nullptr),
+      csr_begin(N * 2 + 1, 0),
+      recent_head(N * 2, NIL),
+      recent_tail(N * 2, NIL),
+      epoch(0),
+      visited(N * 2, 0),
+      layer(N, 0),
+      current_arc(N * 2, NIL)
 {
 }
 
@@ -51,9 +769,62 @@ void LibGA::Matching::addEdge(FieldEdge const* e)
 {
   int s = e->start_index;
   int g = N + e->goal_index;
-  adj[s].push_back(g);
-  adj[g].push_back(s);
-  cost[s][g - N] = e->d;
+  // append to keep the insertion order
+  for (auto [v, u] : {std::make_pair(s, g), std::make_pair(g, s)}) {
+    const int k = recent_target.size();
+    recent_target.push_back(u);
+    recent_cost.push_back(e->d);
+    recent_next.push_back(NIL);
+    if (recent_head[v] == NIL) {
+      recent_head[v] = k;
+    } else {
+      recent_next[recent_tail[v]] = k;
+    }
+    recent_tail[v] = k;
+  }
+
+  // amortized, each arc is moved O(log E) times
+  if (recent_target.size() >= std::max(csr_target.size(), (size_t)N * 2)) {
+    compactEdges();
+  }
+}
+
+void LibGA::Matching::compactEdges()
+{
+  std::vector<int> begin(N * 2 + 1, 0);
+  for (int v = 0; v < N * 2; ++v) {
+    begin[v + 1] = begin[v] + csr_begin[v + 1] - csr_begin[v];
+    for (int k = recent_head[v]; k != NIL; k = recent_next[k]) ++begin[v + 1];
+  }
+  std::vector<int> target(begin[N * 2]);
+  std::vector<int> cost(begin[N * 2]);
+  for (int v = 0; v < N * 2; ++v) {
+    int i = begin[v];
+    for (int a = csr_begin[v]; a < csr_begin[v + 1]; ++a, ++i) {
+      target[i] = csr_target[a];
+      cost[i] = csr_cost[a];
+    }
+    for (int k = recent_head[v]; k != NIL; k = recent_next[k], ++i) {
+      target[i] = recent_target[k];
+      cost[i] = recent_cost[k];
+    }
+    recent_head[v] = NIL;
+    recent_tail[v] = NIL;
+  }
+  csr_begin.swap(begin);
+  csr_target.swap(target);
+  csr_cost.swap(cost);
+  recent_target.clear();
+  recent_cost.clear();
+  recent_next.clear();
+}
+
+int LibGA::Matching::getEdgeCost(const int s, const int g) const
+{
+  for (int a = firstArc(s); a != NIL; a = nextArc(s, a)) {
+    if (getArcHead(a) == g) return getArcCost(a);
+  }
+  return NIL;
 }
 
 void LibGA::Matching::resetCurrentMate()
@@ -78,7 +849,7 @@ int LibGA::Matching::getCost()
   int sum = 0;
   for (int i = 0; i < N; ++i) {
     if (mate[i] == NIL) continue;
-    sum += cost[i][mate[i] - N];
+    sum += getEdgeCost(i, mate[i]);
   }
   return sum;
 }
@@ -88,7 +859,7 @@ int LibGA::Matching::getMakespan()
   int score = 0;
   for (int i = 0; i < N; ++i) {
     if (mate[i] == NIL) continue;
-    score = std::max(score, cost[i][mate[i] - N]);
+    score = std::max(score, getEdgeCost(i, mate[i]));
   }
   return score;
 }
@@ -97,38 +868,124 @@ void LibGA::Matching::updateByIncrementalFordFulkerson(FieldEdge const* e)
 {
   addEdge(e);
 
-  // close list
-  std::vector<bool> CLOSE(N * 2, false);
-
-  // DFS
-  std::function<bool(int)> dfs = [&](int v) {  // start/goal
-    if (CLOSE[v]) return false;
-    CLOSE[v] = true;
-    // expand neighbors
-    for (int u : adj[v]) {  // u: goal/start
-      int w = mate[u];      // w: start/goal
-      // unmatched goal/start is found || found augmented path
-      if (w == NIL || (!CLOSE[w] && dfs(w))) {
-        if (v < N) {  // start
-          mariage(v, u);
+  const int s = e->start_index;
+  const int g = N + e->goal_index;
+  if (mate[s] == NIL) {  // new path must include s
+    ++epoch;
+    augment(s);
+  } else if (mate[g] == NIL) {  // new path must include g
+    ++epoch;
+    augment(g);
+  } else {  // search all, visited nodes are shared
+    ++epoch;
+    for (int v = 0; v < N; ++v) {
+      if (mate[v] == NIL && visited[v] != epoch && augment(v)) break;
+    }
+  }
+}
+
+bool LibGA::Matching::augment(const int v)
+{
+  // DFS with an explicit stack, visited nodes are stamped by epoch
+  stack.clear();
+  stack.push_back(v);
+  visited[v] = epoch;
+  current_arc[v] = firstArc(v);
+  while (!stack.empty()) {
+    const int x = stack.back();  // start/goal
+    int a = current_arc[x];
+    int w = NIL;  // start/goal
+    for (; a != NIL; a = nextArc(x, a)) {
+      w = mate[getArcHead(a)];
+      if (w == NIL || visited[w] != epoch) break;
+    }
+    current_arc[x] = a;
+    if (a == NIL) {  // dead end
+      stack.pop_back();
+      continue;
+    }
+    if (w == NIL) {
+      // unmatched goal/start is found, flip the path from the end
+      for (int i = stack.size() - 1; i >= 0; --i) {
+        const int y = stack[i];
+        const int z = getArcHead(current_arc[y]);
+        if (y < N) {  // start
+          mariage(y, z);
         } else {  // goal
-          mariage(u, v);
+          mariage(z, y);
         }
-        return true;
       }
+      return true;
     }
-    return false;
-  };
+    visited[w] = epoch;
+    current_arc[w] = firstArc(w);
+    stack.push_back(w);
+  }
+  return false;
+}
 
-  const int s = e->start_index;
-  const int g = N + e->goal_index;
-  if (mate[s] == NIL) {  // new path must include s
-    dfs(s);
-  } else if (mate[g] == NIL) {  // new path must include g
-    dfs(g);
-  } else {  // search all
+void LibGA::Matching::updateByHopcroftKarp()
+{
+  std::vector<int> queue;
+  while (true) {
+    // BFS from unmatched starts along alternating paths
+    ++epoch;
+    queue.clear();
+    for (int v = 0; v < N; ++v) {
+      if (mate[v] != NIL) continue;
+      visited[v] = epoch;
+      layer[v] = 0;
+      queue.push_back(v);
+    }
+    bool found = false;
+    for (size_t k = 0; k < queue.size(); ++k) {
+      const int v = queue[k];
+      for (int a = firstArc(v); a != NIL; a = nextArc(v, a)) {
+        const int w = mate[getArcHead(a)];
+        if (w == NIL) {
+          found = true;
+        } else if (visited[w] != epoch) {
+          visited[w] = epoch;
+          layer[w] = layer[v] + 1;
+          queue.push_back(w);
+        }
+      }
+    }
+    if (!found) break;
+
+    // DFS along layers, augmenting paths are vertex-disjoint
+    const int bfs_epoch = epoch;
+    ++epoch;
     for (int v = 0; v < N; ++v) {
-      if (mate[v] == NIL && dfs(v)) break;
+      if (mate[v] != NIL || visited[v] != bfs_epoch) continue;
+      stack.clear();
+      stack.push_back(v);
+      current_arc[v] = firstArc(v);
+      while (!stack.empty()) {
+        const int x = stack.back();
+        int& a = current_arc[x];
+        if (a == NIL) {  // dead end, never visit again in this phase
+          visited[x] = epoch;
+          stack.pop_back();
+          continue;
+        }
+        const int w = mate[getArcHead(a)];
+        if (w == NIL) {
+          // flip the path from the end
+          for (int i = stack.size() - 1; i >= 0; --i) {
+            const int y = stack[i];
+            mariage(y, getArcHead(current_arc[y]));
+            visited[y] = epoch;  // used by this phase
+          }
+          break;
+        }
+        if (visited[w] == bfs_epoch && layer[w] == layer[x] + 1) {
+          current_arc[w] = firstArc(w);
+          stack.push_back(w);
+        } else {
+          a = nextArc(x, a);
+        }
+      }
     }
   }
 }
@@ -141,130 +998,371 @@ void LibGA::Matching::solveBySuccessiveShortestPath()
   // setup sink node
   const int SINK = N * 2;
 
-  // setup neighbors
-  std::vector<int> adj_sink(N);
-  std::iota(adj_sink.begin(), adj_sink.end(), N);
-  adj.push_back(adj_sink);
-  for (int v = N; v < N * 2; ++v) adj[v].push_back(SINK);
+  // goals are connected to the sink
   std::vector<bool> f_to_sink(N, false);
 
   // potential
   std::vector<int> potential(N * 2 + 1, 0);
 
   struct DijkstraNode {
-    int v;            // node
-    int d;            // distance
-    DijkstraNode* p;  // parent
+    int v;  // node
+    int d;  // distance
+    int p;  // parent, index in the arena
   };
-  using DijkstraNodes = std::vector<DijkstraNode*>;
-  auto compare = [&](DijkstraNode* v, DijkstraNode* u) { return v->d > u->d; };
 
-  // avoid "new" operation
-  const int MEMORY_SIZE = N * 40;
-  DijkstraNode GC[MEMORY_SIZE];
+  // search nodes, reused by all iterations
+  std::vector<DijkstraNode> GC;
+  GC.reserve(N * 4);
+  auto createNewNode = [&](int _v, int _d, int _p) {
+    GC.push_back({_v, _d, _p});
+    return (int)GC.size() - 1;
+  };
+
+  // reduced costs are non-negative, popped distances never decrease
+  RadixHeap OPEN;
+
+  // close list
+  std::vector<bool> CLOSE(N * 2 + 1);
+
+  // distance from source
+  std::vector<int> dist(N * 2 + 1);
 
   for (int _i = 0; _i < N; ++_i) {
-    // priority queue
-    std::priority_queue<DijkstraNode*, DijkstraNodes, decltype(compare)> OPEN(
-        compare);
-
-    int node_total_cnt = 0;
-    auto createNewNode = [&](int _v, int _d, DijkstraNode* _p) {
-      if (node_total_cnt >= MEMORY_SIZE)
-        halt("lib_ga, memory over, increase MEMORY_SIZE...");
-      auto q = &(GC[node_total_cnt++]);
-      q->v = _v;
-      q->d = _d;
-      q->p = _p;
-      return q;
-    };
-
-    // close list
-    bool CLOSE[N * 2 + 1];
-    std::memset(CLOSE, false, sizeof(CLOSE));
-
-    // distance from source
-    std::vector<int> dist(N * 2 + 1, INT_MAX);
+    GC.clear();
+    OPEN.clear();
+    std::fill(CLOSE.begin(), CLOSE.end(), false);
+    std::fill(dist.begin(), dist.end(), INT_MAX);
 
     // for backtracking
-    DijkstraNode* sink_p = nullptr;
+    int sink_p = NIL;
 
     // initialize
     for (int v = 0; v < N; ++v) {
       if (mate[v] != NIL) continue;
       dist[v] = 0;
-      OPEN.push(createNewNode(v, 0, nullptr));
+      OPEN.push(0, createNewNode(v, 0, NIL));
     }
 
     // calculate distance
     while (!OPEN.empty()) {
       // minimum node
-      auto n = OPEN.top();
-      OPEN.pop();
+      const int n_index = OPEN.pop();
+      const int n_v = GC[n_index].v;
 
       // check CLOSE list
-      if (CLOSE[n->v]) continue;
-      CLOSE[n->v] = true;
+      if (CLOSE[n_v]) continue;
+      CLOSE[n_v] = true;
+
+      // the shortest augmenting path is found
+      if (n_v == SINK) break;
 
       // expand neighbors
-      for (auto m : adj[n->v]) {
+      auto relax = [&](const int m, const int cost) {
         // already searched
-        if (CLOSE[m]) continue;
+        if (CLOSE[m]) return;
 
         // check connectivity
-        if (n->v < N) {  // start -> goal
-          if (mate[n->v] == m) continue;
-        } else if (n->v < N * 2 && m < N) {  // goal -> start
-          if (mate[n->v] != m) continue;
-        } else if (n->v < N * 2 && m == SINK) {  // goal -> sink
-          if (f_to_sink[n->v - N]) continue;
-        } else if (n->v == SINK) {  // sink -> goal
-          if (!f_to_sink[m - N]) continue;
+        if (n_v < N) {  // start -> goal
+          if (mate[n_v] == m) return;
+        } else if (n_v < N * 2 && m < N) {  // goal -> start
+          if (mate[n_v] != m) return;
+        } else if (n_v < N * 2 && m == SINK) {  // goal -> sink
+          if (f_to_sink[n_v - N]) return;
+        } else if (n_v == SINK) {  // sink -> goal
+          if (!f_to_sink[m - N]) return;
         } else {
           halt("unknown case");
         }
 
         // update distance, s -> g or g -> s
-        int _c = (m == SINK || n->v == SINK)
-                     ? 0
-                     : ((n->v < N) ? cost[n->v][m - N] : -cost[m][n->v - N]);
-        int c = _c + potential[n->v] - potential[m];
-        int d = dist[n->v] + c;
+        int _c = (n_v < N) ? cost : -cost;
+        int c = _c + potential[n_v] - potential[m];
+        int d = dist[n_v] + c;
 
         if (c < 0) halt("invalid cost: " + std::to_string(c));
 
         if (d < dist[m]) {
           dist[m] = d;
-          auto p = createNewNode(m, d, n);
-          OPEN.push(p);
+          const int p = createNewNode(m, d, n_index);
+          OPEN.push(d, p);
 
           // for backtracking
-          if (p->v == SINK) sink_p = p;
+          if (m == SINK) sink_p = p;
+        }
+      };
+      if (n_v == SINK) {
+        for (int v = N; v < N * 2; ++v) relax(v, 0);
+      } else {
+        for (int a = firstArc(n_v); a != NIL; a = nextArc(n_v, a)) {
+          relax(getArcHead(a), getArcCost(a));
         }
+        if (n_v >= N) relax(SINK, 0);
       }
     }
 
-    // update potential
+    // no augmenting path, the graph has no perfect matching
+    if (sink_p == NIL) halt("no augmenting path");
+
+    // update potential, reduced costs remain non-negative with the distances
+    // truncated by that of the sink
     for (int v = 0; v < N * 2 + 1; ++v) {
-      if (!CLOSE[v]) halt("unknown place: " + std::to_string(v));
-      potential[v] += dist[v];
+      potential[v] += std::min(dist[v], dist[SINK]);
     }
 
     // backtracking
-    if (sink_p != nullptr) {
-      auto n = sink_p;
-      while (n->p != nullptr) {
-        if (n->v == SINK) {  // goal -> sink
-          f_to_sink[n->p->v - N] = true;
-        } else if (n->p->v == SINK) {   // sink -> goal
-          f_to_sink[n->v - N] = false;  // meaningless
-        } else if (n->v >= N) {         // start -> goal
-          mariage(n->p->v, n->v);
+    auto n = &GC[sink_p];
+    while (n->p != NIL) {
+      auto n_p = &GC[n->p];
+      if (n->v == SINK) {  // goal -> sink
+        f_to_sink[n_p->v - N] = true;
+      } else if (n_p->v == SINK) {    // sink -> goal
+        f_to_sink[n->v - N] = false;  // meaningless
+      } else if (n->v >= N) {         // start -> goal
+        mariage(n_p->v, n->v);
+      } else {  // goal -> start
+        // pass
+      }
+      n = n_p;
+    }
+  }
+}
+
+void LibGA::Matching::solveByCycleCanceling()
+{
+  const int V = N * 2;
+
+  // cost of the matched edge of each goal
+  std::vector<int> mate_cost(N, 0);
+  auto updateMateCost = [&](const int g) {
+    if (mate[g] != NIL) mate_cost[g - N] = getEdgeCost(mate[g], g);
+  };
+  for (int g = N; g < V; ++g) updateMateCost(g);
+
+  // SPFA from a virtual source connected to all nodes. When no arc can be
+  // relaxed, dist is a feasible potential that certifies the optimality.
+  std::vector<int> dist(V, 0);
+  std::vector<int> parent(V, NIL);  // tail of the last relaxed arc
+  std::vector<bool> queued(V, true);
+  std::queue<int> Q;
+  for (int v = 0; v < V; ++v) Q.push(v);
+
+  // cycles of the parent graph are negative, cancel all of them, i.e.,
+  // each start on a cycle takes the next goal
+  std::vector<int> mark(V);
+  std::vector<int> cycle;
+  auto cancelCycles = [&]() {
+    std::fill(mark.begin(), mark.end(), NIL);
+    for (int v_s = 0; v_s < V; ++v_s) {
+      int v = v_s;
+      while (v != NIL && mark[v] == NIL) {
+        mark[v] = v_s;
+        v = parent[v];
+      }
+      if (v == NIL || mark[v] != v_s) continue;
+      cycle.clear();
+      const int v_cycle = v;
+      do {
+        cycle.push_back(v);
+        v = parent[v];
+      } while (v != v_cycle);
+      for (auto g : cycle) {
+        if (g >= N) mariage(parent[g], g);
+      }
+      // arcs on the cycle are reversed
+      for (auto u : cycle) {
+        if (u >= N) updateMateCost(u);
+        parent[u] = NIL;
+        if (!queued[u]) {
+          queued[u] = true;
+          Q.push(u);
+        }
+      }
+    }
+  };
+
+  int relaxed_cnt = 0;
+  auto relax = [&](const int v, const int u, const int c) {
+    if (dist[v] + c >= dist[u]) return;
+    dist[u] = dist[v] + c;
+    parent[u] = v;
+    ++relaxed_cnt;
+    if (!queued[u]) {
+      queued[u] = true;
+      Q.push(u);
+    }
+  };
+
+  while (!Q.empty()) {
+    const int v = Q.front();
+    Q.pop();
+    queued[v] = false;
+    if (v < N) {  // start -> goal, unmatched
+      for (int a = firstArc(v); a != NIL; a = nextArc(v, a)) {
+        const int g = getArcHead(a);
+        if (mate[v] != g) relax(v, g, getArcCost(a));
+      }
+    } else if (mate[v] != NIL) {  // goal -> start, matched
+      relax(v, mate[v], -mate_cost[v - N]);
+    }
+
+    // check the parent graph periodically, O(V) amortized by relaxations
+    if (relaxed_cnt >= V) {
+      relaxed_cnt = 0;
+      cancelCycles();
+    }
+  }
+
+  potential.swap(dist);
+}
+
+void LibGA::Matching::solveByAuction(ThreadPool* pool, const double gap)
+{
+  // clear the previous results
+  resetCurrentMate();
+  if (N == 0) return;
+
+  // benefits are scaled costs so that epsilon = 1 results in the optimum
+  using Value = int64_t;
+  const Value scale = N + 1;
+  Value c_max = 0;
+  for (int i = 0; i < N; ++i) {
+    for (int a = firstArc(i); a != NIL; a = nextArc(i, a)) {
+      c_max = std::max(c_max, (Value)getArcCost(a));
+    }
+  }
+  auto benefit = [&](const int a) { return -(Value)getArcCost(a) * scale; };
+  // used as the second best value when there is only one choice
+  const Value spread = (c_max + 1) * scale;
+  constexpr Value NONE = INT64_MIN;
+
+  std::vector<Value> price(N, 0);   // goal
+  std::vector<Value> profit(N, 0);  // start
+  std::vector<int> owner(N, NIL);   // goal -> start
+  std::vector<int> target(N, NIL);  // start -> goal
+  std::vector<int> target_cost(N, 0);
+
+  // bids of one round
+  std::vector<int> bidders;
+  std::vector<int> bid_to(N);
+  std::vector<int> bid_cost(N);
+  std::vector<Value> bid_value(N);  // new price (forward) or profit (reverse)
+  std::vector<Value> bid_rest(N);   // new profit (forward) or price (reverse)
+  std::vector<int> winner(N, NIL);
+  std::vector<int> touched;
+
+  for (Value eps = std::max((Value)1, c_max * scale / AUCTION_EPS_FACTOR);;
+       eps = std::max((Value)1, eps / AUCTION_EPS_FACTOR)) {
+    // restart with current prices, profits satisfy complementary slackness
+    std::fill(owner.begin(), owner.end(), NIL);
+    std::fill(target.begin(), target.end(), NIL);
+    int assigned_num = 0;
+    for (int i = 0; i < N; ++i) {
+      profit[i] = NONE;
+      for (int a = firstArc(i); a != NIL; a = nextArc(i, a)) {
+        const int j = getArcHead(a) - N;
+        profit[i] = std::max(profit[i], benefit(a) - price[j]);
+      }
+    }
+
+    bool forward = true;
+    while (assigned_num < N) {
+      bidders.clear();
+      for (int k = 0; k < N; ++k) {
+        if ((forward ? target[k] : owner[k]) == NIL) bidders.push_back(k);
+      }
+
+      // compute bids
+      pool->parallelFor(bidders.size(), [&](const int k, const int) {
+        const int u = bidders[k];
+        const int offset = forward ? N : 0;
+        int best = NIL, best_arc = NIL;
+        Value v1 = NONE, v2 = NONE;
+        const int x = u + N - offset;
+        for (int a = firstArc(x); a != NIL; a = nextArc(x, a)) {
+          const int w = getArcHead(a) - offset;
+          const Value val = benefit(a) - (forward ? price[w] : profit[w]);
+          if (val > v1) {
+            v2 = v1;
+            v1 = val;
+            best = w;
+            best_arc = a;
+          } else if (val > v2) {
+            v2 = val;
+          }
+        }
+        if (v2 == NONE) v2 = v1 - spread;
+        bid_to[k] = best;
+        bid_cost[k] = getArcCost(best_arc);
+        bid_value[k] = benefit(best_arc) - v2 + eps;
+        bid_rest[k] = v2 - eps;
+      });
+
+      // resolve conflicts, the highest bid wins
+      touched.clear();
+      for (int k = 0; k < (int)bidders.size(); ++k) {
+        const int w = bid_to[k];
+        if (winner[w] == NIL) {
+          winner[w] = k;
+          touched.push_back(w);
+        } else if (bid_value[k] > bid_value[winner[w]]) {
+          winner[w] = k;
+        }
+      }
+      const int assigned_num_prev = assigned_num;
+      for (auto w : touched) {
+        const int k = winner[w];
+        winner[w] = NIL;
+        if (forward) {  // start -> goal
+          const int i = bidders[k];
+          if (owner[w] == NIL) {
+            ++assigned_num;
+          } else {
+            target[owner[w]] = NIL;
+          }
+          owner[w] = i;
+          target[i] = w;
+          target_cost[i] = bid_cost[k];
+          price[w] = bid_value[k];
+          profit[i] = bid_rest[k];
         } else {  // goal -> start
-          // pass
+          const int j = bidders[k];
+          if (target[w] == NIL) {
+            ++assigned_num;
+          } else {
+            owner[target[w]] = NIL;
+          }
+          target[w] = j;
+          target_cost[w] = bid_cost[k];
+          owner[j] = w;
+          profit[w] = bid_value[k];
+          price[j] = bid_rest[k];
         }
-        n = n->p;
       }
+
+      // switch the direction after the assignment grows
+      if (assigned_num > assigned_num_prev) forward = !forward;
+    }
+
+    if (eps == 1) break;  // optimal
+
+    // dual lower bound of the sum of costs
+    if (gap > 0) {
+      Value dual = 0;
+      for (int j = 0; j < N; ++j) dual += price[j];
+      for (int i = 0; i < N; ++i) {
+        Value pi = NONE;
+        for (int a = firstArc(i); a != NIL; a = nextArc(i, a)) {
+          const int j = getArcHead(a) - N;
+          pi = std::max(pi, benefit(a) - price[j]);
+        }
+        dual += pi;
+      }
+      const Value lb = std::max((Value)0, (-dual + scale - 1) / scale);
+      Value primal = 0;
+      for (int i = 0; i < N; ++i) primal += target_cost[i];
+      if (primal <= lb + gap * lb) break;
     }
   }
+
+  for (int i = 0; i < N; ++i) mariage(i, target[i] + N);
 }
@@ -7,7 +7,9 @@
 const std::string NaiveTSWAP::SOLVER_NAME = "NaiveTSWAP";
 
 NaiveTSWAP::NaiveTSWAP(Problem* _P)
-    : Solver(_P), assignment_mode(GoalAllocator::BOTTLENECK_LINEAR)
+    : Solver(_P),
+      assignment_mode(GoalAllocator::BOTTLENECK_LINEAR),
+      num_threads(1)
 {
   solver_name = SOLVER_NAME;
 }
@@ -21,6 +23,7 @@ void NaiveTSWAP::run()
   // goal assignment
   info(" ", "start task allocation");
   GoalAllocator allocator = GoalAllocator(P, assignment_mode);
+  allocator.setThreads(num_threads);
   allocator.assign();
   auto goals = allocator.getAssignedGoals();
 
@@ -138,15 +141,20 @@ void NaiveTSWAP::setParams(int argc, char* argv[])
 {
   struct option longopts[] = {
       {"mode", no_argument, 0, 'm'},
+      {"threads", required_argument, 0, 't'},
       {0, 0, 0, 0},
   };
   optind = 1;  // reset
   int opt, longindex;
-  while ((opt = getopt_long(argc, argv, "m:", longopts, &longindex)) != -1) {
+  while ((opt = getopt_long(argc, argv, "m:t:", longopts, &longindex)) !=
+         -1) {
     switch (opt) {
       case 'm':
         assignment_mode = static_cast<GoalAllocator::MODE>(std::atoi(optarg));
         break;
+      case 't':
+        num_threads = std::atoi(optarg);
+        break;
       default:
         break;
     }
@@ -157,7 +165,12 @@ void NaiveTSWAP::printHelp()
 {
   std::cout << NaiveTSWAP::SOLVER_NAME << "\n"
 
-            << "  nothing"
+            << "  -m --mode"
+            << "                     "
+            << "assignment mode, same as TSWAP\n"
+            << "  -t --threads [NUM]"
+            << "            "
+            << "threads for target assignment, default: 1"
 
             << std::endl;
 }
@@ -2,12 +2,14 @@
 
 Config Plan::get(int t) const
 {
+  if (streamed()) halt("invalid operation, the plan is streamed");
   if (!(0 <= t && t < configs.size())) halt("invalid timestep");
   return configs[t];
 }
 
 Node* Plan::get(int t, int i) const
 {
+  if (streamed()) halt("invalid operation, the plan is streamed");
   if (empty()) halt("invalid operation");
   if (!(0 <= t && t < configs.size())) halt("invalid timestep");
   if (!(0 <= i && i < configs[0].size())) halt("invalid agent id");
@@ -16,26 +18,36 @@ Node* Plan::get(int t, int i) const
 
 Config Plan::last() const
 {
+  if (streamed()) halt("invalid operation, the plan is streamed");
   if (empty()) halt("invalid operation");
   return configs[configs.size() - 1];
 }
 
 void Plan::add(const Config& c)
 {
+  if (streamed()) {
+    writer->add(c);
+    return;
+  }
   if (!configs.empty() && configs.at(0).size() != c.size()) {
     halt("invalid operation");
   }
   configs.push_back(c);
 }
 
-bool Plan::empty() const { return configs.empty(); }
+bool Plan::empty() const { return size() == 0; }
 
-int Plan::size() const { return configs.size(); }
+int Plan::size() const
+{
+  if (streamed()) return writer->size();
+  return configs.size();
+}
 
-int Plan::getMakespan() const { return configs.size() - 1; }
+int Plan::getMakespan() const { return size() - 1; }
 
 int Plan::getSOC() const
 {
+  if (streamed()) return writer->getSOC();
   int makespan = getMakespan();
   if (makespan <= 0) return 0;
   int num_agents = configs[0].size();
@@ -80,10 +92,15 @@ void Plan::operator+=(const Plan& other)
   for (int t = 1; t < other.size(); ++t) add(other.get(t));
 }
 
-void Plan::clear() { configs.clear(); }
+void Plan::clear()
+{
+  configs.clear();
+  writer.reset();
+}
 
 bool Plan::validate(Problem* P) const
 {
+  if (streamed()) return writer->validate();
   if (configs.empty()) return false;
 
   // start and goal
@@ -129,3 +146,26 @@ bool Plan::validate(Problem* P) const
   }
   return true;
 }
+
+void Plan::setWriter(std::shared_ptr<PlanWriter> _writer)
+{
+  writer = _writer;
+}
+
+void Plan::flush()
+{
+  if (streamed()) writer->close();
+}
+
+void Plan::write(std::ostream& os) const
+{
+  if (streamed()) {
+    writer->copyTo(os);
+    return;
+  }
+  for (int t = 0; t < size(); ++t) {
+    os << t << ":";
+    for (auto v : configs[t]) os << "(" << v->pos.x << "," << v->pos.y << "),";
+    os << "\n";
+  }
+}
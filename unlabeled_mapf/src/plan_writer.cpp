@@ -0,0 +1,175 @@
+#include "../include/plan_writer.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+PlanWriter::PlanWriter(Problem* _P)
+    : P(_P),
+      G(_P->getG()),
+      N(_P->getNum()),
+      ring(CAPACITY),
+      pushed(0),
+      popped(0),
+      closed(false),
+      file(std::tmpfile()),
+      num_configs(0),
+      config_prev(N, -1),
+      last_move(N, 0),
+      agent_prev(G->getNodesSize(), -1),
+      visited(G->getNodesSize(), -1)
+{
+  if (file == nullptr) halt("failed to create a temporary file for the plan");
+  writer = std::thread(&PlanWriter::loop, this);
+}
+
+PlanWriter::~PlanWriter()
+{
+  close();
+  std::fclose(file);
+}
+
+void PlanWriter::add(const Config& c)
+{
+  if ((int)c.size() != N) halt("invalid operation");
+  int k;
+  {
+    std::unique_lock<std::mutex> lk(m);
+    if (closed) halt("invalid operation");
+    cv_push.wait(lk, [&]() { return pushed - popped < CAPACITY; });
+    k = pushed % CAPACITY;
+  }
+  // the slot is not read until pushed is incremented
+  auto& slot = ring[k];
+  slot.resize(N);
+  for (int i = 0; i < N; ++i) slot[i] = c[i]->id;
+  {
+    std::lock_guard<std::mutex> lk(m);
+    ++pushed;
+  }
+  cv_pop.notify_one();
+}
+
+void PlanWriter::close()
+{
+  {
+    std::lock_guard<std::mutex> lk(m);
+    closed = true;
+  }
+  cv_pop.notify_one();
+  if (writer.joinable()) writer.join();
+}
+
+void PlanWriter::loop()
+{
+  std::vector<int> c;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lk(m);
+      cv_pop.wait(lk, [&]() { return popped < pushed || closed; });
+      if (popped == pushed) break;  // closed
+      c.swap(ring[popped % CAPACITY]);
+      ++popped;
+    }
+    cv_push.notify_one();
+    check(c);
+    write(c);
+  }
+  std::fflush(file);
+}
+
+void PlanWriter::check(const std::vector<int>& c)
+{
+  const int t = num_configs++;
+  if (!error.empty()) {
+    config_prev = c;
+    return;
+  }
+
+  if (t == 0) {
+    for (int i = 0; i < N; ++i) {
+      if (c[i] != P->getStart(i)->id) error = "starts do not match";
+    }
+  } else {
+    // continuity, vertex conflicts, and swap conflicts
+    for (int i = 0; i < N; ++i) {
+      const int u = config_prev[i];
+      const int v = c[i];
+      if (G->getNode(u)->manhattanDist(G->getNode(v)) > 1) {
+        error = "detect invalid moves";
+        break;
+      }
+      if (visited[v] == t) {
+        error = "detect vertex conflicts";
+        break;
+      }
+      visited[v] = t;
+      const int j = agent_prev[v];
+      if (j != -1 && j != i && c[j] == u) {
+        error = "detect swap conflicts";
+        break;
+      }
+      if (u != v) last_move[i] = t;
+    }
+    for (int i = 0; i < N; ++i) agent_prev[config_prev[i]] = -1;
+  }
+  for (int i = 0; i < N; ++i) agent_prev[c[i]] = i;
+  config_prev = c;
+}
+
+void PlanWriter::write(const std::vector<int>& c)
+{
+  std::fprintf(file, "%d:", num_configs - 1);
+  for (auto id : c) {
+    auto v = G->getNode(id);
+    std::fprintf(file, "(%d,%d),", v->pos.x, v->pos.y);
+  }
+  std::fputc('\n', file);
+}
+
+void PlanWriter::checkClosed() const
+{
+  if (!closed) halt("invalid operation, the plan is not flushed");
+}
+
+int PlanWriter::size() const
+{
+  checkClosed();
+  return num_configs;
+}
+
+int PlanWriter::getSOC() const
+{
+  checkClosed();
+  if (num_configs <= 1) return 0;
+  int soc = 0;
+  for (auto t : last_move) soc += t;
+  return soc;
+}
+
+bool PlanWriter::validate() const
+{
+  checkClosed();
+  if (num_configs == 0) return false;
+  std::string reason = error;
+  if (reason.empty()) {
+    // goals
+    std::vector<int> goals(N);
+    for (int i = 0; i < N; ++i) goals[i] = P->getGoal(i)->id;
+    auto last = config_prev;
+    std::sort(goals.begin(), goals.end());
+    std::sort(last.begin(), last.end());
+    if (goals != last) reason = "goals do not match";
+  }
+  if (reason.empty()) return true;
+  std::cout << reason << std::endl;
+  return false;
+}
+
+void PlanWriter::copyTo(std::ostream& os) const
+{
+  checkClosed();
+  std::rewind(file);
+  char buf[1 << 16];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) os.write(buf, n);
+}
@@ -1,5 +1,6 @@
 #include "../include/problem.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <regex>
 
@@ -122,11 +123,12 @@ Problem::Problem(const std::string& _instance)
 
 Problem::Problem(Problem* P, Config _config_s, Config _config_g,
                  int _max_comp_time, int _max_timestep)
-    : G(P->getG()),
+    : instance(P->getInstanceFileName()),
+      G(P->getG()),
       MT(P->getMT()),
       config_s(_config_s),
       config_g(_config_g),
-      num_agents(P->getNum()),
+      num_agents(_config_s.size()),
       max_timestep(_max_timestep),
       max_comp_time(_max_comp_time),
       instance_initialized(false)
@@ -156,6 +158,50 @@ Node* Problem::getGoal(int i) const
   return config_g[i];
 }
 
+void Problem::blockNode(Node* const v)
+{
+  if (isBlocked(v)) return;
+
+  // nodes are saved before their first edit
+  original_neighbors.emplace(v, v->neighbor);
+  for (auto u : v->neighbor) {
+    original_neighbors.emplace(u, u->neighbor);
+    u->neighbor.erase(std::find(u->neighbor.begin(), u->neighbor.end(), v));
+  }
+  v->neighbor.clear();
+  blocked_nodes.insert(v);
+}
+
+void Problem::unblockNode(Node* const v)
+{
+  if (!isBlocked(v)) return;
+  blocked_nodes.erase(v);
+
+  // rebuild adjacency in the original order, without blocked nodes
+  auto restore = [&](Node* const w) {
+    w->neighbor.clear();
+    for (auto u : original_neighbors[w]) {
+      if (!isBlocked(u)) w->neighbor.push_back(u);
+    }
+  };
+  restore(v);
+  for (auto u : v->neighbor) restore(u);
+}
+
+bool Problem::isBlocked(Node* const v) const
+{
+  return blocked_nodes.find(v) != blocked_nodes.end();
+}
+
+Nodes Problem::getBlockedNodes() const
+{
+  Nodes nodes;
+  for (auto v : blocked_nodes) nodes.push_back(v);
+  std::sort(nodes.begin(), nodes.end(),
+            [](Node* v, Node* u) { return v->id < u->id; });
+  return nodes;
+}
+
 void Problem::setRandomStartsGoals(const int flocking_blocks)
 {
   const int group_num = (flocking_blocks <= 0 || flocking_blocks > num_agents)
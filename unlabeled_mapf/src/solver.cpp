@@ -206,12 +206,5 @@ void Solver::makeLogSolution(std::ofstream& log)
   }
   log << "\n";
   log << "solution=\n";
-  for (int t = 0; t <= solution.getMakespan(); ++t) {
-    log << t << ":";
-    auto c = solution.get(t);
-    for (auto v : c) {
-      log << "(" << v->pos.x << "," << v->pos.y << "),";
-    }
-    log << "\n";
-  }
+  solution.write(log);
 }
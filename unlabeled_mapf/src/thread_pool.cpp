@@ -0,0 +1,113 @@
+#include "../include/thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(const int _num_threads)
+    : num_threads(std::max(1, _num_threads)),
+      task(nullptr),
+      generation(0),
+      working(0),
+      terminated(false)
+{
+  for (int k = 0; k < num_threads; ++k)
+    ranges.push_back(std::make_unique<Range>());
+  // worker 0 is the caller of parallelFor
+  for (int k = 1; k < num_threads; ++k)
+    workers.emplace_back(&ThreadPool::loop, this, k);
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m);
+    terminated = true;
+  }
+  cv_start.notify_all();
+  for (auto& th : workers) th.join();
+}
+
+void ThreadPool::parallelFor(const int n, const Task& f)
+{
+  if (num_threads == 1 || n <= 1) {
+    for (int i = 0; i < n; ++i) f(i, 0);
+    return;
+  }
+
+  // split indexes evenly
+  for (int k = 0; k < num_threads; ++k) {
+    std::lock_guard<std::mutex> lock(ranges[k]->m);
+    ranges[k]->begin = (long)n * k / num_threads;
+    ranges[k]->end = (long)n * (k + 1) / num_threads;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m);
+    task = &f;
+    working = num_threads - 1;
+    ++generation;
+  }
+  cv_start.notify_all();
+
+  work(0);
+
+  std::unique_lock<std::mutex> lock(m);
+  cv_finish.wait(lock, [&] { return working == 0; });
+  task = nullptr;
+}
+
+void ThreadPool::loop(const int worker_id)
+{
+  int seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m);
+      cv_start.wait(lock, [&] { return terminated || generation != seen; });
+      if (terminated) return;
+      seen = generation;
+    }
+
+    work(worker_id);
+
+    std::lock_guard<std::mutex> lock(m);
+    if (--working == 0) cv_finish.notify_one();
+  }
+}
+
+void ThreadPool::work(const int worker_id)
+{
+  auto& own = *ranges[worker_id];
+  while (true) {
+    int i = -1;
+    {
+      std::lock_guard<std::mutex> lock(own.m);
+      if (own.begin < own.end) i = own.begin++;
+    }
+    if (i >= 0) {
+      (*task)(i, worker_id);
+    } else if (!steal(worker_id)) {
+      return;
+    }
+  }
+}
+
+bool ThreadPool::steal(const int worker_id)
+{
+  for (int k = 1; k < num_threads; ++k) {
+    auto& victim = *ranges[(worker_id + k) % num_threads];
+    int begin, end;
+    {
+      std::lock_guard<std::mutex> lock(victim.m);
+      if (victim.begin >= victim.end) continue;
+      // take the latter half
+      begin = victim.begin + (victim.end - victim.begin) / 2;
+      end = victim.end;
+      victim.end = begin;
+    }
+    auto& own = *ranges[worker_id];
+    std::lock_guard<std::mutex> lock(own.m);
+    own.begin = begin;
+    own.end = end;
+    return true;
+  }
+  return false;
+}
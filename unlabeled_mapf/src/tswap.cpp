@@ -1,15 +1,35 @@
 #include "../include/tswap.hpp"
 
-#include <alloca.h>
-
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <future>
+#include <regex>
 
 const std::string TSWAP::SOLVER_NAME = "TSWAP";
 
 TSWAP::TSWAP(Problem* _P)
     : Solver(_P),
+      A(P->getNum()),
       assignment_mode(GoalAllocator::BOTTLENECK_LINEAR),
-      goal_indexes(G->getNodesSize(), -1)
+      num_threads(1),
+      oracle_file(""),
+      num_landmarks(0),
+      auction_gap(0),
+      level_batch(true),
+      refine_exhaustive(false),
+      anytime_steps(0),
+      field_cache_size(0),
+      resumable_astar(false),
+      next_hop(false),
+      stream_plan(false),
+      planning_threads(1),
+      planning_deterministic(false),
+      edits_file(""),
+      goal_indexes(G->getNodesSize(), -1),
+      lazy_eval_expanded_assignment(0),
+      lazy_eval_expanded(0),
+      map_edits(0)
 {
   solver_name = SOLVER_NAME;
   for (int i = 0; i < P->getNum(); ++i) goal_indexes[P->getGoal(i)->id] = i;
@@ -25,128 +45,242 @@ TSWAP::~TSWAP() {}
 void TSWAP::run()
 {
   Plan plan;  // will be solution
+  if (stream_plan) plan.setWriter(std::make_shared<PlanWriter>(P));
   const int K = G->getNodesSize();
 
   // goal assignment
   info(" ", "start task allocation");
-  allocator = std::make_shared<GoalAllocator>(P, assignment_mode);
+  std::shared_ptr<DistanceOracle> oracle;
+  if (!oracle_file.empty())
+    oracle = std::make_shared<DistanceOracle>(G, oracle_file);
+  if (field_cache == nullptr && field_cache_size > 0) {
+    field_cache = LibGA::FieldCache::getShared();
+    field_cache->setCapacity((size_t)field_cache_size << 20);
+  }
+  std::shared_ptr<LibGA::Landmarks> landmarks;
+  if (num_landmarks > 0)
+    landmarks = std::make_shared<LibGA::Landmarks>(G, num_landmarks);
+  auto makeAllocator = [&](const GoalAllocator::MODE mode) {
+    auto ga = std::make_shared<GoalAllocator>(P, mode);
+    ga->setThreads(num_threads);
+    ga->setAuctionGap(auction_gap);
+    ga->setLevelBatch(level_batch);
+    ga->setRefineExhaustive(refine_exhaustive);
+    if (oracle != nullptr) ga->setOracle(oracle);
+    if (field_cache != nullptr) ga->setFieldCache(field_cache);
+    ga->setResumableAstar(resumable_astar);
+    ga->setNextHop(next_hop);
+    if (landmarks != nullptr) ga->setLandmarks(landmarks);
+    return ga;
+  };
+
+  // anytime, start with greedy-swap while the assignment runs in background
+  std::shared_ptr<GoalAllocator> allocator_improved;
+  std::future<void> improving;  // cancelled at the end at the latest
+  int interim_moves = 0;        // moves with greedy-swap goals
+  elapsed_assignment_improved = 0;
+  timestep_improved = 0;
+  if (anytime_steps > 0 && assignment_mode != GoalAllocator::GREEDY_SWAP) {
+    allocator_improved = makeAllocator(assignment_mode);
+    improving = std::async(std::launch::async,
+                           [&]() { allocator_improved->assign(); });
+    allocator = makeAllocator(GoalAllocator::GREEDY_SWAP);
+  } else {
+    allocator = makeAllocator(assignment_mode);
+  }
   allocator->assign();
   auto goals = allocator->getAssignedGoals();
 
+  auto updateEstimation = [&]() {
+    estimated_soc = allocator->getCost();
+    estimated_makespan = allocator->getMakespan();
+    lazy_eval_avoided = allocator->getLazyEvalAvoided();
+    lazy_eval_expanded_assignment = allocator->getLazyEvalExpanded();
+    info(" ", "elapsed:", getSolverElapsedTime(), ", finish goal assignment",
+         ", soc: >=", estimated_soc, ", makespan: >=", estimated_makespan);
+    if (num_landmarks > 0)
+      info(" ", "lazy evaluations avoided by landmarks:", lazy_eval_avoided);
+  };
   elapsed_assignment = getSolverElapsedTime();
-  estimated_soc = allocator->getCost();
-  estimated_makespan = allocator->getMakespan();
-
-  info(" ", "elapsed:", elapsed_assignment, ", finish goal assignment",
-       ", soc: >=", estimated_soc, ", makespan: >=", estimated_makespan);
+  updateEstimation();
 
   auto t_pathplanning = Time::now();
 
-  // compare priority of agents
-  auto compare = [](Agent* a, const Agent* b) {
-    if (a->called != b->called) return a->called > b->called;
-    if (a->v_now != a->g) return false;
-    if (b->v_now != b->g) return true;
-    return a < b;
-  };
+  const int N = P->getNum();
 
-  // agents have not decided their next locations
-  std::priority_queue<Agent*, Agents, decltype(compare)> U(compare);
+  // agents have not decided their next locations, the goal condition is
+  // checked when pushed
+  AgentQueue U;
+  auto pushAgent = [&](const int i) {
+    U.push(i, A.called[i], A.v_now[i] == A.g[i]);
+  };
 
-  // work as reservation table
-  Agents occupied_now(K, nullptr);   // current location
-  Agents occupied_next(K, nullptr);  // next location
+  // work as reservation table of agents, the next locations are claimed by
+  // CAS when planning in parallel
+  std::vector<int> occupied_now(K, NIL);           // current location
+  std::vector<std::atomic<int>> occupied_next(K);  // next location
+  for (auto& i : occupied_next) i = NIL;
 
   // actions
-  auto moveTo = [&](Agent* a, Node* v) {
-    a->v_next = v;
-    occupied_next[v->id] = a;
+  auto moveTo = [&](const int i, const int v) {
+    A.v_next[i] = v;
+    occupied_next[v] = i;
   };
-  auto stay = [&](Agent* a) { moveTo(a, a->v_now); };
-  auto swapGoal = [&](Agent* a, Agent* b) {
-    Node* v = b->g;
-    b->g = a->g;
-    a->g = v;
-  };
-
-  // all agents
-  Agent A[P->getNum()];
+  auto stay = [&](const int i) { moveTo(i, A.v_now[i]); };
+  auto swapGoal = [&](const int i, const int j) { std::swap(A.g[i], A.g[j]); };
 
   // setup agents
-  for (int i = 0; i < P->getNum(); ++i) {
-    auto a = &(A[i]);
-    a->id = i;                  // id
-    a->v_now = P->getStart(i);  // current node
-    a->v_next = nullptr;        // next node
-    a->g = goals[i];            // goal
-    a->called = 0;  // how many times an agent is called in the queue
-    occupied_now[a->v_now->id] = a;
-
-    // insert OPEN set
-    U.push(a);
+  for (int i = 0; i < N; ++i) {
+    A.v_now[i] = P->getStart(i)->id;
+    A.v_next[i] = NIL;
+    A.g[i] = goals[i]->id;
+    A.called[i] = 0;
+    A.g_u[i] = NIL;
+    occupied_now[A.v_now[i]] = i;
   }
 
+  // agents are partitioned into strips of rows when planning in parallel
+  if (planning_threads > 1)
+    planning_pool = std::make_unique<ThreadPool>(planning_threads);
+  const int B = planning_threads * 8;  // more than threads for balance
+  std::vector<std::vector<int>> strips(B);
+
   // set initial config
   plan.add(P->getConfigStart());
 
+  // map edits, distance fields are repaired instead of being rebuilt
+  loadEdits();
+  auto itr_edit = edits.begin();
+  Nodes edited;  // blocked by edits, unblocked after solving
+  auto repairFields = [&](const Nodes& blocked, const Nodes& unblocked) {
+    allocator->repairFields(blocked, unblocked);
+    if (allocator_improved != nullptr && allocator_improved != allocator)
+      allocator_improved->repairFields(blocked, unblocked);
+  };
+  auto applyEdits = [&](const int timestep) {
+    if (itr_edit == edits.end() || itr_edit->timestep > timestep) return;
+    // the graph is used in background, given up at the time limit
+    if (improving.valid()) {
+      const int wait = std::max(0, max_comp_time - (int)getSolverElapsedTime());
+      if (improving.wait_for(std::chrono::milliseconds(wait)) !=
+          std::future_status::ready) {
+        allocator_improved->cancel();
+        improving.get();  // not switched
+      }
+    }
+    Nodes blocked, unblocked;
+    for (; itr_edit != edits.end() && itr_edit->timestep <= timestep;
+         ++itr_edit) {
+      auto v = itr_edit->v;
+      if (itr_edit->blocked == P->isBlocked(v)) continue;
+      if (itr_edit->blocked) {
+        if (occupied_now[v->id] != NIL || goal_indexes[v->id] != -1) {
+          warn("skip blocking an occupied node or a goal, timestep=" +
+               std::to_string(timestep));
+          continue;
+        }
+        P->blockNode(v);
+        blocked.push_back(v);
+        edited.push_back(v);
+      } else {
+        P->unblockNode(v);
+        unblocked.push_back(v);
+      }
+      ++map_edits;
+    }
+    repairFields(blocked, unblocked);
+    info(" ", "timestep:", timestep, ", block", blocked.size(),
+         "nodes, unblock", unblocked.size(), "nodes");
+  };
+
   // main loop
   int timestep = 0;
   while (true) {
+    applyEdits(timestep);
+
+    // parallel planning, each goal belongs to one agent so that distances
+    // are evaluated concurrently, then agents claim vacant nodes (rule-2)
+    // unless deterministic, the others are left to the serial pass, agents
+    // at goals too since they might swap goals with others
+    if (planning_pool != nullptr) {
+      for (auto& strip : strips) strip.clear();
+      for (int i = 0; i < N; ++i)
+        strips[(int64_t)A.v_now[i] * B / K].push_back(i);
+      planning_pool->parallelFor(B, [&](const int k, const int) {
+        for (auto i : strips[k]) {
+          if (A.v_now[i] == A.g[i]) continue;
+          const int u = getDesiredNode(i);
+          if (planning_deterministic) continue;
+          if (occupied_now[u] != NIL) continue;
+          int expected = NIL;
+          if (occupied_next[u].compare_exchange_strong(expected, i))
+            A.v_next[i] = u;  // rule-2
+        }
+      });
+    }
+    for (int i = 0; i < N; ++i) {
+      if (A.v_next[i] == NIL) pushAgent(i);
+    }
+
     // planning
     while (!U.empty()) {
       // pickup one agent
-      Agent* a_i = U.top();
-      U.pop();
-      a_i->called++;
+      const int i = U.pop();
+      A.called[i]++;
 
       // rule 1. stay goal
-      if (a_i->v_now == a_i->g) {
-        stay(a_i);
+      if (A.v_now[i] == A.g[i]) {
+        stay(i);
         continue;
       }
 
       // get desired node
-      auto u = getNextNode(a_i->v_now, a_i->g);
+      const int u = getDesiredNode(i);
 
       // if u is occupied in the *next* timestep -> stay
-      auto a_j = occupied_next[u->id];
-      if (a_j != nullptr) {
-        if (a_j->v_next == a_j->g) swapGoal(a_i, a_j);  // rule-3
-        stay(a_i);                                      // rule-5
+      int j = occupied_next[u];
+      if (j != NIL) {
+        if (A.v_next[j] == A.g[j]) swapGoal(i, j);  // rule-3
+        stay(i);                                    // rule-5
         continue;
       }
 
       // if u is occupied in the *current* timestep
-      a_j = occupied_now[u->id];
-      if (a_j == nullptr || (a_j->v_now == u && a_j->v_next != nullptr)) {
-        moveTo(a_i, u);  // rule-2
+      j = occupied_now[u];
+      if (j == NIL || (A.v_now[j] == u && A.v_next[j] != NIL)) {
+        moveTo(i, u);  // rule-2
         continue;
       }
 
-      U.push(a_i);
-      if (a_j != nullptr && a_j->v_now == a_j->g) swapGoal(a_i, a_j);  // rule-3
-      deadlockDetectResolve(a_i, occupied_now);                        // rule-4
+      pushAgent(i);
+      if (j != NIL && A.v_now[j] == A.g[j]) swapGoal(i, j);  // rule-3
+      deadlockDetectResolve(i, occupied_now);                // rule-4
     }
 
-    // acting
-    bool check_goal_cond = true;
-    Config config(P->getNum(), nullptr);
-    for (int i = 0; i < P->getNum(); ++i) {
-      Agent* a = &(A[i]);
-      // clear
-      occupied_next[a->v_next->id] = nullptr;
-      if (occupied_now[a->v_now->id] == a) occupied_now[a->v_now->id] = nullptr;
-      // set next location
-      config[i] = a->v_next;
-      occupied_now[a->v_next->id] = a;
-      // check goal condition
-      check_goal_cond &= (a->v_next == a->g);
-      // reset params
-      a->v_now = a->v_next;
-      a->v_next = nullptr;
-      a->called = 0;
-      // push to priority queue
-      U.push(a);
+    // acting, clear the reservation table
+    for (int i = 0; i < N; ++i) {
+      occupied_next[A.v_next[i]] = NIL;
+      if (occupied_now[A.v_now[i]] == i) occupied_now[A.v_now[i]] = NIL;
+    }
+
+    // move and check the goal condition in one pass over the arrays
+    int goal_cond = 1;
+    const bool interim = improving.valid();
+    for (int i = 0; i < N; ++i) {
+      goal_cond &= (A.v_next[i] == A.g[i]);
+      if (interim && A.v_next[i] != A.v_now[i]) ++interim_moves;
+      A.v_now[i] = A.v_next[i];
+      A.v_next[i] = NIL;
+      A.called[i] = 0;
+      A.g_u[i] = NIL;
+    }
+    bool check_goal_cond = goal_cond;
+
+    // set next locations
+    Config config(N, nullptr);
+    for (int i = 0; i < N; ++i) {
+      occupied_now[A.v_now[i]] = i;
+      config[i] = G->getNode(A.v_now[i]);
     }
 
     // update plan
@@ -154,6 +288,39 @@ void TSWAP::run()
 
     ++timestep;
 
+    // anytime, hand improved goals over at the timestep boundary,
+    // wait for them after the interim steps within the time limit
+    if (improving.valid() && !check_goal_cond) {
+      int wait = 0;  // ms
+      if (timestep >= anytime_steps)
+        wait = std::max(0, max_comp_time - (int)getSolverElapsedTime());
+      if (improving.wait_for(std::chrono::milliseconds(wait)) ==
+          std::future_status::ready) {
+        improving.get();
+        allocator = allocator_improved;
+        // Agents have moved. The local repair from the current locations is
+        // kept when it reduces the cost by the interim moves, i.e., they
+        // were made toward the improved goals, otherwise the assignment is
+        // recomputed from the current locations. Moves away from the
+        // improved goals cannot be undone, hence the sum of costs can exceed
+        // that without anytime by up to N * NUM.
+        const int cost_target = allocator->getCost() - interim_moves;
+        for (int i = 0; i < N; ++i)
+          allocator->moveAgent(i, G->getNode(A.v_now[i]));
+        allocator->reassign();
+        if (allocator->getCost() > cost_target) allocator->assign();
+        goals = allocator->getAssignedGoals();
+        check_goal_cond = true;
+        for (int i = 0; i < N; ++i) {
+          A.g[i] = goals[i]->id;
+          check_goal_cond &= (A.v_now[i] == A.g[i]);
+        }
+        elapsed_assignment_improved = getSolverElapsedTime();
+        timestep_improved = timestep;
+        updateEstimation();
+      }
+    }
+
     // success
     if (check_goal_cond) {
       solved = true;
@@ -166,16 +333,80 @@ void TSWAP::run()
     }
   }
 
+  // not switched, the background assignment is no longer needed
+  if (improving.valid()) {
+    allocator_improved->cancel();
+    improving.wait();
+  }
+
+  plan.flush();
   elapsed_pathplanning = getElapsedTime(t_pathplanning);
+  lazy_eval_expanded = allocator->getLazyEvalExpanded();
+
+  // the plan is validated on the original map
+  Nodes restored;
+  for (auto v : edited) {
+    if (!P->isBlocked(v)) continue;
+    P->unblockNode(v);
+    restored.push_back(v);
+  }
+  if (!restored.empty()) repairFields({}, restored);
 
   info(" ", "elapsed:", getSolverElapsedTime(), ", finish path planning");
 
   solution = plan;
 }
 
+TSWAP::AgentQueue::AgentQueue() : called_min(0), num(0) {}
+
+void TSWAP::AgentQueue::push(const int i, const int c, const bool at_goal)
+{
+  if (c >= (int)moving.size()) {
+    moving.resize(c + 1);
+    heads.resize(c + 1, 0);
+    staying.resize(c + 1);
+    sorted.resize(c + 1, true);
+  }
+  auto& bucket = at_goal ? staying[c] : moving[c];
+  if (!bucket.empty() && bucket.back() > i) sorted[c] = false;
+  bucket.push_back(i);
+  called_min = std::min(called_min, c);
+  ++num;
+}
+
+int TSWAP::AgentQueue::pop()
+{
+  while (true) {
+    auto& bucket = moving[called_min];
+    auto& head = heads[called_min];
+    if (!sorted[called_min]) {
+      // moving by ascending index from the head, staying by descending index
+      // from the back
+      std::sort(bucket.begin() + head, bucket.end());
+      std::sort(staying[called_min].begin(), staying[called_min].end());
+      sorted[called_min] = true;
+    }
+    if (head < (int)bucket.size()) {
+      --num;
+      return bucket[head++];
+    }
+    bucket.clear();
+    head = 0;
+    if (!staying[called_min].empty()) {
+      const int i = staying[called_min].back();
+      staying[called_min].pop_back();
+      --num;
+      return i;
+    }
+    ++called_min;
+  }
+}
+
 Node* TSWAP::getNextNode(Node* a, Node* b)
 {
   int i = goal_indexes[b->id];
+  auto u = allocator->getNextHop(a, i);
+  if (u != nullptr) return u;
   int cost_baseline = allocator->getLazyEval(a, i);
   for (auto m : a->neighbor) {
     if (m == b) return b;  // goal
@@ -184,53 +415,153 @@ Node* TSWAP::getNextNode(Node* a, Node* b)
   return a;
 }
 
-bool TSWAP::deadlockDetectResolve(Agent* a, std::vector<Agent*>& occupied_now)
+int TSWAP::getDesiredNode(const int i)
+{
+  if (A.g_u[i] != A.g[i]) {
+    A.u[i] = getNextNode(G->getNode(A.v_now[i]), G->getNode(A.g[i]))->id;
+    A.g_u[i] = A.g[i];
+  }
+  return A.u[i];
+}
+
+bool TSWAP::deadlockDetectResolve(const int i,
+                                  const std::vector<int>& occupied_now)
 {
   // deadlock detection
-  std::vector<Agent*> A_p;
-  Agent* b = a;
+  std::vector<int> A_p;
+  int b = i;
   while (true) {
-    if (b->v_now == b->g || b->v_next != nullptr) break;  // not deadlock
-    auto c = occupied_now[getNextNode(b->v_now, b->g)->id];
-    if (c == nullptr) break;  // not deadlock
+    if (A.v_now[b] == A.g[b] || A.v_next[b] != NIL) break;  // not deadlock
+    const int c = occupied_now[getDesiredNode(b)];
+    if (c == NIL) break;  // not deadlock
     A_p.push_back(b);
     b = c;
     if (A_p.size() > 1) {
-      if (b == a) break;  // deadlock
+      if (b == i) break;  // deadlock
 
-      // there is a deadlock, but "a" is not in the deadlock
+      // there is a deadlock, but "i" is not in the deadlock
       if (inArray(b, A_p)) {
         A_p.clear();
         break;
       }
     }
   }
-  if (A_p.size() > 1 && b == a) {  // when detecting deadlock
+  if (A_p.size() > 1 && b == i) {  // when detecting deadlock
     // rotate targets
-    Node* g = (*(A_p.end() - 1))->g;
+    const int g = A.g[*(A_p.end() - 1)];
     for (auto itr = A_p.end() - 1; itr != A_p.begin(); --itr)
-      (*itr)->g = (*(itr - 1))->g;
-    (*A_p.begin())->g = g;
+      A.g[*itr] = A.g[*(itr - 1)];
+    A.g[*A_p.begin()] = g;
     return true;
   }
 
   return false;
 }
 
+void TSWAP::loadEdits()
+{
+  edits.clear();
+  if (edits_file.empty()) return;
+  std::ifstream file(edits_file);
+  if (!file) halt("file " + edits_file + " is not found.");
+
+  // timestep,x,y,1 -> block, timestep,x,y,0 -> unblock
+  std::string line;
+  std::smatch results;
+  std::regex r_edit = std::regex(R"((\d+),(\d+),(\d+),([01]))");
+  while (getline(file, line)) {
+    if (!std::regex_match(line, results, r_edit)) continue;
+    const int x = std::stoi(results[2].str());
+    const int y = std::stoi(results[3].str());
+    if (!G->existNode(x, y)) {
+      halt("node (" + std::to_string(x) + ", " + std::to_string(y) +
+           ") does not exist, invalid map edit");
+    }
+    edits.push_back({std::stoi(results[1].str()), G->getNode(x, y),
+                     results[4].str() == "1"});
+  }
+  std::stable_sort(edits.begin(), edits.end(),
+                   [](const MapEdit& a, const MapEdit& b) {
+                     return a.timestep < b.timestep;
+                   });
+}
+
+void TSWAP::setFieldCache(std::shared_ptr<LibGA::FieldCache> _field_cache)
+{
+  field_cache = _field_cache;
+}
+
 void TSWAP::setParams(int argc, char* argv[])
 {
   struct option longopts[] = {
       {"mode", no_argument, 0, 'm'},
       {"off-tie-break", no_argument, 0, 'b'},
+      {"threads", required_argument, 0, 't'},
+      {"oracle", required_argument, 0, 'O'},
+      {"landmarks", required_argument, 0, 'L'},
+      {"auction-gap", required_argument, 0, 'g'},
+      {"no-level-batch", no_argument, 0, 'B'},
+      {"exhaustive-refine", no_argument, 0, 'E'},
+      {"anytime", required_argument, 0, 'A'},
+      {"field-cache", required_argument, 0, 'C'},
+      {"edits", required_argument, 0, 'e'},
+      {"resumable-astar", no_argument, 0, 'R'},
+      {"planning-threads", required_argument, 0, 'p'},
+      {"deterministic-planning", no_argument, 0, 'D'},
+      {"next-hop", no_argument, 0, 'H'},
+      {"stream-plan", no_argument, 0, 'W'},
       {0, 0, 0, 0},
   };
   optind = 1;  // reset
   int opt, longindex;
-  while ((opt = getopt_long(argc, argv, "m:", longopts, &longindex)) != -1) {
+  while ((opt = getopt_long(argc, argv, "m:t:O:L:g:BEA:C:e:Rp:DHW", longopts,
+                            &longindex)) != -1) {
     switch (opt) {
       case 'm':
         assignment_mode = static_cast<GoalAllocator::MODE>(std::atoi(optarg));
         break;
+      case 't':
+        num_threads = std::atoi(optarg);
+        break;
+      case 'O':
+        oracle_file = std::string(optarg);
+        break;
+      case 'L':
+        num_landmarks = std::atoi(optarg);
+        break;
+      case 'g':
+        auction_gap = std::atof(optarg);
+        break;
+      case 'B':
+        level_batch = false;
+        break;
+      case 'E':
+        refine_exhaustive = true;
+        break;
+      case 'A':
+        anytime_steps = std::atoi(optarg);
+        break;
+      case 'C':
+        field_cache_size = std::atoi(optarg);
+        break;
+      case 'e':
+        edits_file = std::string(optarg);
+        break;
+      case 'R':
+        resumable_astar = true;
+        break;
+      case 'p':
+        planning_threads = std::atoi(optarg);
+        break;
+      case 'D':
+        planning_deterministic = true;
+        break;
+      case 'H':
+        next_hop = true;
+        break;
+      case 'W':
+        stream_plan = true;
+        break;
       default:
         break;
     }
@@ -254,7 +585,56 @@ void TSWAP::printHelp()
       << "                                    5: greedy-swap\n"
       << "                                    6: greedy-swap (without lazy "
          "eval)\n"
-      << "                                    7: greedy-swap-cost"
+      << "                                    7: greedy-swap-cost\n"
+      << "                                    8: bottleneck-linear (auction)\n"
+      << "                                    9: hierarchical (regions)\n"
+      << "                                    10: linear (k-nearest "
+         "candidates)\n"
+      << "  -t --threads [NUM]"
+      << "            "
+      << "threads for target assignment, default: 1\n"
+      << "  -O --oracle [FILE_PATH]"
+      << "       "
+      << "distance oracle of the map, see --make-oracle\n"
+      << "  -L --landmarks [NUM]"
+      << "          "
+      << "landmarks for lower bounds, default: 0 (Manhattan)\n"
+      << "  -g --auction-gap [NUM]"
+      << "        "
+      << "acceptable suboptimality of mode 8, default: 0\n"
+      << "  -B --no-level-batch"
+      << "           "
+      << "bottleneck matching per pair instead of per distance level\n"
+      << "  -E --exhaustive-refine"
+      << "        "
+      << "check all pairs in refinement of modes 5-7\n"
+      << "  -A --anytime [NUM]"
+      << "            "
+      << "move with greedy-swap for at most NUM steps until the assignment "
+         "is ready, default: 0 (off)\n"
+      << "  -C --field-cache [MB]"
+      << "         "
+      << "share distance fields of goals among problems in the process, "
+         "default: 0 (off)\n"
+      << "  -e --edits [FILE_PATH]"
+      << "        "
+      << "block/unblock nodes at timesteps, each line: t,x,y,1 or t,x,y,0\n"
+      << "  -R --resumable-astar"
+      << "          "
+      << "lazy distance evaluation by reverse-resumable A* instead of BFS\n"
+      << "  -p --planning-threads [NUM]"
+      << "   "
+      << "threads for path planning, default: 1\n"
+      << "  -D --deterministic-planning"
+      << "   "
+      << "parallel path planning gives the same plans as serial one\n"
+      << "  -H --next-hop"
+      << "                 "
+      << "precompute next nodes toward goals, 2 bits per node and agent\n"
+      << "  -W --stream-plan"
+      << "              "
+      << "write the plan to a temporary file while planning instead of "
+         "keeping it in memory"
 
       << std::endl;
 }
@@ -267,9 +647,21 @@ void TSWAP::makeLog(const std::string& logfile)
 
   log << "internal_info=\n"
       << "elapsed_assignment:" << elapsed_assignment << "\n"
+      << "elapsed_assignment_improved:" << elapsed_assignment_improved << "\n"
+      << "timestep_improved:" << timestep_improved << "\n"
       << "elapsed_path_planning:" << elapsed_pathplanning << "\n"
       << "estimated_soc:" << estimated_soc << "\n"
-      << "estimated_makespan:" << estimated_makespan << "\n";
+      << "estimated_makespan:" << estimated_makespan << "\n"
+      << "lazy_eval_avoided_by_landmarks:" << lazy_eval_avoided << "\n"
+      << "lazy_eval_expanded_assignment:" << lazy_eval_expanded_assignment
+      << "\n"
+      << "lazy_eval_expanded:" << lazy_eval_expanded << "\n"
+      << "map_edits:" << map_edits << "\n";
+  if (field_cache != nullptr) {
+    log << "field_cache_hits:" << field_cache->getHits() << "\n"
+        << "field_cache_misses:" << field_cache->getMisses() << "\n"
+        << "field_cache_evictions:" << field_cache->getEvictions() << "\n";
+  }
 
   makeLogSolution(log);
   log.close();